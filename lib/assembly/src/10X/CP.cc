@@ -324,7 +324,7 @@ int main( int argc, char *argv[] )
           {    if ( !report) BinaryReader::readFile( DIR + "/a.bad", &bad );    }
           #pragma omp section
           {    BinaryReader::readFile( DIR + "/a.hbx", &hb );
-               if ( !report ) paths.readBinary(DIR + "/a.pathsX");  }
+               if ( !report ) paths.mapBinary(DIR + "/a.pathsX");  }
           #pragma omp section
           if ( SAMPLE != "unknown" ) FetchFinished( SAMPLE, G, NCLONES, NSEED );
           #pragma omp section
@@ -1219,7 +1219,7 @@ int main( int argc, char *argv[] )
                Splat( hb, inv, cpaths, D, dinv );
                cout << Date() << ": about to reload paths" << endl;
                double clock = WallClockTime();
-               paths.readBinary( DIR+"/a.pathsX" );
+               paths.mapBinary( DIR+"/a.pathsX" );
                cout << Date() << ": reloaded paths in " 
                     << TimeSince(clock) << endl;    }
           BasicWrite( "post" );    }
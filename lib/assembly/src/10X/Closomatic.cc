@@ -357,8 +357,10 @@ template< class VB, class VQ, class VP, class VPI >
 void CloseGap( const HyperBasevectorX& hb, const vec<int>& inv, 
      VB& bases, VQ& quals, VP& paths, VPI& paths_index,
      const int e1, const int e2, vec<basevector>& closures, Bool verbose, 
-     const int pi, const int max_width )
+     const int pi, const int max_width, const double deadline )
 {    closures.clear( );
+     auto out_of_time = [&]( )
+          { return deadline > 0 && WallClockTime( ) > deadline; };
      ostringstream out;
      if (verbose) out << "\n";
      if (verbose) PRINT2_TO( out, e1, e2 );
@@ -382,7 +384,8 @@ void CloseGap( const HyperBasevectorX& hb, const vec<int>& inv,
           for ( int pass = 1; pass <= 2; pass++ )
           {    const int f = ( pass == 1 ? e : inv[e] );
                for ( int i = 0; i < (int) paths_index[f].size( ); i++ )
-               {    int64_t id = paths_index[f][i];
+               {    if ( out_of_time( ) ) return;
+                    int64_t id = paths_index[f][i];
                     const ReadPath& p = paths[id];
                     for ( int j = 0; j < (int) p.size( ); j++ )
                     {    if ( p[j] == f )
@@ -402,7 +405,8 @@ void CloseGap( const HyperBasevectorX& hb, const vec<int>& inv,
                else M = Max( M, ne - pos );    }
           readstack stack( locs.size( ), M );
           for ( int i = 0; i < locs.isize( ); i++ )
-          {    int64_t id = locs[i].first;
+          {    if ( out_of_time( ) ) return;
+               int64_t id = locs[i].first;
                qualvector q;
                quals[id].unpack(&q);
                int pos = locs[i].second;
@@ -440,6 +444,7 @@ void CloseGap( const HyperBasevectorX& hb, const vec<int>& inv,
 
      // Merge stacks.
 
+     if ( out_of_time( ) ) return;
      int verbosity = 0; // could be 1 or 2
      if (verbose) verbosity = 3;
      int delta_mis = 0;
@@ -462,29 +467,31 @@ template void CloseGap( const HyperBasevectorX& hb, const vec<int>& inv,
      MasterVec<basevector>& bases, MasterVec<PQVec>& quals,
      MasterVec<ReadPath>& paths, MasterVec<ULongVec>& paths_index,
      const int e1, const int e2, vec<basevector>& closure, Bool verbose, 
-     const int pi, const int max_width );
+     const int pi, const int max_width, const double deadline );
 
 template void CloseGap( const HyperBasevectorX& hb, const vec<int>& inv,
      MasterVec<basevector>& bases, SubsetMasterVec<PQVec>& quals,
      SubsetMasterVec<ReadPath>& paths, SubsetMasterVec<ULongVec>& paths_index,
      const int e1, const int e2, vec<basevector>& closure, Bool verbose, 
-     const int pi, const int max_width );
+     const int pi, const int max_width, const double deadline );
 
 template void CloseGap( const HyperBasevectorX& hb, const vec<int>& inv,
      VirtualMasterVec<basevector>& bases, VirtualMasterVec<PQVec>& quals,
      VirtualMasterVec<ReadPath>& paths, VirtualMasterVec<ULongVec>& paths_index,
      const int e1, const int e2, vec<basevector>& closure, Bool verbose, 
-     const int pi, const int max_width );
+     const int pi, const int max_width, const double deadline );
 
 template< class VB, class VQ, class VP, class VPI >
 void CloseGap2( const HyperBasevectorX& hb, const vec<int>& inv, 
      VB& bases, VQ& quals, VP& paths, VPI& paths_index,
      const int e1, const int e2, vec<basevector>& closures, Bool verbose, 
-     const int pi, const int max_width )
+     const int pi, const int max_width, const double deadline )
 {    
      // Setup.
 
      closures.clear( );
+     auto out_of_time = [&]( )
+          { return deadline > 0 && WallClockTime( ) > deadline; };
      ostringstream out;
      if (verbose) out << "\n";
      if (verbose) PRINT2_TO( out, e1, e2 );
@@ -507,7 +514,8 @@ void CloseGap2( const HyperBasevectorX& hb, const vec<int>& inv,
           for ( int pass = 1; pass <= 2; pass++ )
           {    const int f = ( pass == 1 ? e : inv[e] );
                for ( int i = 0; i < (int) paths_index[f].size( ); i++ )
-               {    int64_t id = paths_index[f][i];
+               {    if ( out_of_time( ) ) return;
+                    int64_t id = paths_index[f][i];
                     const ReadPath& p = paths[id];
                     int n = p.size( );
                     for ( int j = 0; j < n; j++ )
@@ -532,7 +540,8 @@ void CloseGap2( const HyperBasevectorX& hb, const vec<int>& inv,
           Sort(prec);
           if ( verbose ) cout << ( ei == 0 ? "LEFT:\n" : "RIGHT:\n" ) << endl;
           for ( int i = 0; i < prec.isize( ); i++ )
-          {    int j;
+          {    if ( out_of_time( ) ) return;
+               int j;
                for ( j = i + 1; j < prec.isize( ); j++ )
                     if ( prec[j] != prec[i] ) break;
                if ( j - i >= MIN_EDGE_COUNT )
@@ -557,7 +566,8 @@ void CloseGap2( const HyperBasevectorX& hb, const vec<int>& inv,
           UniqueSort( ids[ei] ), UniqueSort( bod[ei] );    }
      for ( int ei = 0; ei < 2; ei++ )
      {    for ( int j = 0; j < ids[ei].isize( ); j++ )
-          {    int64_t id1 = ids[ei][j];
+          {    if ( out_of_time( ) ) return;
+               int64_t id1 = ids[ei][j];
                int64_t id2 = ( id1 % 2 == 0 ? id1+1 : id1-1 );
                if ( BinMember( ids[1-ei], id2 ) ) continue;
      
@@ -600,7 +610,8 @@ void CloseGap2( const HyperBasevectorX& hb, const vec<int>& inv,
                else M = Max( M, ne - pos );    }
           readstack stack( locs[ei].size( ), M );
           for ( int i = 0; i < locs[ei].isize( ); i++ )
-          {    int64_t id = locs[ei][i].first;
+          {    if ( out_of_time( ) ) return;
+               int64_t id = locs[ei][i].first;
                qualvector q;
                quals[id].unpack(&q);
                int pos = locs[ei][i].second;
@@ -638,6 +649,7 @@ void CloseGap2( const HyperBasevectorX& hb, const vec<int>& inv,
 
      // Merge stacks.
 
+     if ( out_of_time( ) ) return;
      int verbosity = 0; // could be 1 or 2
      if (verbose) verbosity = 3;
      int delta_mis = 0;
@@ -660,16 +672,16 @@ template void CloseGap2( const HyperBasevectorX& hb, const vec<int>& inv,
      MasterVec<basevector>& bases, MasterVec<PQVec>& quals,
      MasterVec<ReadPath>& paths, MasterVec<ULongVec>& paths_index,
      const int e1, const int e2, vec<basevector>& closure, Bool verbose,
-     const int pi, const int max_width );
+     const int pi, const int max_width, const double deadline );
 
 template void CloseGap2( const HyperBasevectorX& hb, const vec<int>& inv,
      MasterVec<basevector>& bases, SubsetMasterVec<PQVec>& quals,
      SubsetMasterVec<ReadPath>& paths, SubsetMasterVec<ULongVec>& paths_index,
      const int e1, const int e2, vec<basevector>& closure, Bool verbose,
-     const int pi, const int max_width );
+     const int pi, const int max_width, const double deadline );
 
 template void CloseGap2( const HyperBasevectorX& hb, const vec<int>& inv,
      VirtualMasterVec<basevector>& bases, VirtualMasterVec<PQVec>& quals,
      VirtualMasterVec<ReadPath>& paths, VirtualMasterVec<ULongVec>& paths_index,
      const int e1, const int e2, vec<basevector>& closure, Bool verbose,
-     const int pi, const int max_width );
+     const int pi, const int max_width, const double deadline );
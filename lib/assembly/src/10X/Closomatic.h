@@ -18,16 +18,20 @@ void FindEdgePairs( const HyperBasevectorX& hb, const vec<int>& inv,
      vec< pair<int,int> >& pairs, const vec<DataSet>& datasets,
      const vec<int32_t>& bc, const Bool one_good );
 
+// CloseGap and CloseGap2: find closures of the gap from edge e1 to edge e2.
+// If deadline is positive, give up, returning no closures, once WallClockTime( )
+// passes it.
+
 template< class VB, class VQ, class VP, class VPI >
 void CloseGap( const HyperBasevectorX& hb, const vec<int>& inv, 
      VB& bases, VQ& quals, VP& paths, VPI& paths_index,
      const int e1, const int e2, vec<basevector>& closures, Bool verbose, 
-     const int pi, const int max_width );
+     const int pi, const int max_width, const double deadline = 0 );
 
 template< class VB, class VQ, class VP, class VPI >
 void CloseGap2( const HyperBasevectorX& hb, const vec<int>& inv, 
      VB& bases, VQ& quals, VP& paths, VPI& paths_index,
      const int e1, const int e2, vec<basevector>& closures, Bool verbose, 
-     const int pi, const int max_width );
+     const int pi, const int max_width, const double deadline = 0 );
 
 #endif
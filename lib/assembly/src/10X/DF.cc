@@ -17,15 +17,16 @@
 
 void FirstLoadData( String const& work_dir, String const& read_head, vec<String>& cleanupFiles,
           Bool const PREDUP, String const& KEEP, String const& R, vec<String> const& lr,
-          vec<double> const& LR_SELECT_FRAC,
-          vec<int16_t>& lens, vec<vec<vec<int64_t>>>& qhist,
+          vec<double> const& LR_SELECT_FRAC, Bool const ADOPT_INPUT,
+          int const K, int const MIN_QUAL, vec<int16_t>& lens, vec<vec<vec<int64_t>>>& qhist,
           vecbvec& bases, ObjectManager<VecPQVec>& quals_om, vec<int64_t>& bci,
           vec<String>& subsam_names, vec<int64_t>& subsam_starts, vec<DataSet>& datasets, 
           int & max_read_length )
 {
      PRINTDEETS("load data");
      auto& quals = quals_om.create();
-     LoadData( work_dir, R, lr, LR_SELECT_FRAC, bases, quals_om, bci, subsam_names, subsam_starts, datasets );
+     LoadData( work_dir, R, lr, LR_SELECT_FRAC, ADOPT_INPUT, bases, quals_om, bci,
+               subsam_names, subsam_starts, datasets );
 
      if ( bases.empty( ) )
           Martian::exit("Supernova has been supplied with zero reads and will terminate.");
@@ -39,14 +40,10 @@ void FirstLoadData( String const& work_dir, String const& read_head, vec<String>
 
      if ( PREDUP ) {
           auto nbases = bases.size();
-          Predup( bases, quals, bci );
+          Predup( bases, quals, bci, work_dir + "/data/frag_reads_predup" );
           cout << Date() << ": Predup removed " <<
                ( nbases - bases.size() )  * 10000 / nbases / 100.0 << "% of reads" << endl;
-          cout << Date() << ": writing Predup versions of bases, quals" << endl;
-          bases.WriteAll( work_dir + "/data/frag_reads_predup.fastb" );
           quals_om.newFile( work_dir + "/data/frag_reads_predup.qualp" );
-          quals_om.store();
-          BinaryWriter::writeFile( work_dir + "/data/frag_reads_predup.bci", bci );
 
           cleanupFiles.push_back( work_dir + "/data/frag_reads_predup.fastb" );
           cleanupFiles.push_back( work_dir + "/data/frag_reads_predup.qualp" );
@@ -61,7 +58,11 @@ void FirstLoadData( String const& work_dir, String const& read_head, vec<String>
                max_read_length=lens[i];
      }
 
-     GetQualStats( quals, qhist, max_read_length );
+     GoodLens good_lens( K, MIN_QUAL, quals.size( ) );
+     GetQualStats( quals, qhist, max_read_length, &good_lens );
+     cout << Date() << ": writing " << work_dir << read_head << ".goodlens" << endl;
+     BinaryWriter::writeFile( work_dir + read_head + ".goodlens", good_lens );
+     cleanupFiles.push_back( work_dir + read_head + ".goodlens" );
 
      if ( KEEP != "none" ) {
           // this writes to either pre-dup or orig as needed
@@ -111,10 +112,21 @@ int main( int argc, char *argv[] )
      CommandArgument_Bool_OrDefault_Doc(STACKSTER_ALT, False, "passed to Stackster");
      CommandArgument_Double_OrDefault_Doc(GRAPHMEM, 0.9,
 		 "fraction of memory to allow ReadQGrapher to grab" );
+     CommandArgument_String_OrDefault_Doc(GRAPHSPILL, "",
+          "if set, a directory (preferably on local disk) where ReadQGrapher "
+          "spills kmers when they don't fit in memory all at once" );
+     CommandArgument_UnsignedInt_OrDefault_Doc(PATHING_PREFETCH_DEPTH,
+          DEFAULT_PATHING_PREFETCH_DEPTH,
+          "when pathing reads, how many kmers of a gap to hash and prefetch "
+          "before looking them up; 1 turns prefetching off" );
+     CommandArgument_UnsignedInt_OrDefault_Doc(PATHSX_SKIP, 10,
+          "reads per index entry in pathsX: larger shrinks the index, smaller "
+          "speeds up looking up single reads; passes over all reads don't "
+          "use it" );
      CommandArgument_Bool_OrDefault_Doc(EXIT_LOAD, False,
           "exit after loading and writing data");
      CommandArgument_Bool_OrDefault_Doc(EXIT_BUILD, False,
-          "exit after building a.48");
+          "exit after building a.K");
      CommandArgument_String_OrDefault_Doc(CHR, "", "if set, only align to this "
           "chromosome, which should be an integer");
      CommandArgument_String_OrDefault_Doc(FINAL, "a.base",
@@ -122,6 +134,9 @@ int main( int argc, char *argv[] )
      CommandArgument_String_OrDefault_Doc(GRAPH, "", "if set, use MSP graph csv file ");
      CommandArgument_Bool_OrDefault_Doc(PREDUP, False,
                "use Predup for cleaning input reads");
+     CommandArgument_Bool_OrDefault_Doc(ADOPT_INPUT, True,
+               "given a single LR input, link its files into the data directory "
+               "instead of copying them");
      CommandArgument_String_OrDefault_Doc(REF, "hg19", 
           "reference sequence, either hg19 or fos100");
      CommandArgument_Bool_OrDefault_Doc(RESCUE, False, "rescue kmers");
@@ -135,7 +150,8 @@ int main( int argc, char *argv[] )
                "output summary report to a file" );
      // ALGORITHMIC HEURISTICS
 
-     CommandArgument_Int_OrDefault_Doc(K, 48, "K value for base graph");
+     CommandArgument_Int_OrDefault_Doc(K, 48, "K value for base graph; "
+          "a multiple of 4 from 32 to 96");
      CommandArgument_Int_OrDefault_Doc(MIN_FREQ, 3, "passed to ReadQGrapher");
      CommandArgument_Int_OrDefault_Doc(MIN_BC, 2, "passed to ReadQGrapher");
      CommandArgument_Int_OrDefault_Doc(MIN_QUAL, 7, "passed to ReadQGrapher");
@@ -167,12 +183,16 @@ int main( int argc, char *argv[] )
      Bool STACKSTER      = True;
      Bool STACKSTER_ALT  = False;
      double GRAPHMEM     = 0.9;
+     String GRAPHSPILL   = "";
+     unsigned PATHING_PREFETCH_DEPTH = DEFAULT_PATHING_PREFETCH_DEPTH;
+     unsigned PATHSX_SKIP = 10;
      Bool EXIT_LOAD      = False;
      Bool EXIT_BUILD     = False;
      String CHR          = "";
      String FINAL        = "a.base";
      String GRAPH        = "";
      Bool PREDUP         = False;
+     Bool ADOPT_INPUT    = True;
      String REF          = "hg19";
      Bool RESCUE         = False;
      String USER         = "";
@@ -203,6 +223,16 @@ int main( int argc, char *argv[] )
           "exceeded by our code");
      CommandArgument_String_OrDefault_Doc(MSPEDGES, "",
           "Edges from the MSP stage" );
+     CommandArgument_Int_OrDefault_Doc(PATCH_MAX_READS, 0,
+          "when patching, skip edge pairs having more reads than this on their "
+          "edges; 0 for no limit" );
+     CommandArgument_Double_OrDefault_Doc(PATCH_MAX_SECONDS, 0,
+          "when patching, give up on an edge pair once this many seconds have "
+          "gone to it; Stackster and CloseGap check this as they go and stop "
+          "without closures; 0 for no limit, and results depend on timing "
+          "otherwise" );
+     CommandArgument_Bool_OrDefault_Doc(PATCH_STATS, False,
+          "write per-pair patching times to a.patch_stats" );
      
      EndCommandArguments;
 
@@ -218,7 +248,9 @@ int main( int argc, char *argv[] )
      // Check args.
      RunStages start( START, {"", "loaded", "patch", "trim", "dups", "alltinks"} );
 
-     ForceAssert( K == 40 || K == 48 || K == 60 );
+     if ( !isGraphK(K) )
+     {    cout << "K must be a multiple of 4 from 32 to 96." << endl;
+          Scram(1);    }
      if ( KEEP == "none" && START == "loaded" )
      {    cout << "I'm not sure you really want to do this, since it will\n"
                << "delete your starting files.  So I'm going to quit." << endl;
@@ -312,7 +344,7 @@ int main( int argc, char *argv[] )
 
      if ( START == "" ) {
           FirstLoadData( work_dir, read_head, cleanupFiles, PREDUP, KEEP, R, lr,
-                    LR_SELECT_FRAC, lens, qhist, bases, quals_om, bci, 
+                    LR_SELECT_FRAC, ADOPT_INPUT, K, MIN_QUAL, lens, qhist, bases, quals_om, bci, 
                     subsam_names, subsam_starts, datasets, max_read_length );
      } else {
           /* this is awful */
@@ -328,17 +360,26 @@ int main( int argc, char *argv[] )
                     lens[i] = bases[i].size( );
                BinaryWriter::writeFile(
                     work_dir + read_head + ".lens", lens );    }
-          if ( !IsRegularFile( work_dir + read_head + ".qhist" ) )
+          // Redo the quality scan if its results are missing or stale.
+
+          GoodLens good_lens;
+          String gl_file = work_dir + read_head + ".goodlens";
+          if ( IsRegularFile(gl_file) )
+               BinaryReader::readFile( gl_file, &good_lens );
+          BinaryReader::readFile(work_dir + read_head + ".lens", &lens);
+          if ( !IsRegularFile( work_dir + read_head + ".qhist" )
+               || !good_lens.matches( K, MIN_QUAL, lens.size( ) ) )
           {    VecPQVec quals( work_dir + read_head + ".qualp" );
-               BinaryReader::readFile(work_dir + read_head + ".lens", &lens);
                max_read_length=0;
                for (int64_t i = 0; i != int64_t(lens.size()); i++) {
                     if (max_read_length < lens[i]) 
                          max_read_length=lens[i];
                }
-               GetQualStats( quals, qhist, max_read_length );
+               good_lens = GoodLens( K, MIN_QUAL, quals.size( ) );
+               GetQualStats( quals, qhist, max_read_length, &good_lens );
                BinaryWriter::writeFile(
-                    work_dir + read_head + ".qhist", qhist ); }    }
+                    work_dir + read_head + ".qhist", qhist );
+               BinaryWriter::writeFile( gl_file, good_lens ); }    }
      if ( START != "" )
      {    cout << Date( ) << ": loading data" << endl;
           if ( START != "alltinks" )
@@ -365,30 +406,10 @@ int main( int argc, char *argv[] )
      // bad cycle detection
      // % Q30 on R2
      {
-          // Compute whether we have a cycle failure
-          // defined as 50 % or greater of the reads 
-          // having a base with Q <= 2 at a fixed cycle
-          vec <int> bad_cycles(2, 0);
-          double max_low_q_base_fraction=0.0;
-          int MIN_READS = 1000; // only alert if we have at least 1000 reads 
-          for ( int ri = 0; ri != 2; ri++ ) {
-               for ( int pos = 0; pos != int(qhist[ri].size()); pos++ ) {
-                    float low_q=0.0, all_q=0.0;
-                    for ( int q = 0; q != int(qhist[ri][pos].size()); q++ ) {
-                         if ( q <= 2 )
-                              low_q += qhist[ri][pos][q];
-                         all_q += qhist[ri][pos][q];
-                    }
-                    if ( all_q > MIN_READS ) {
-                         if ( max_low_q_base_fraction < low_q/all_q ) 
-                              max_low_q_base_fraction = low_q/all_q;
-                         if ( low_q/all_q > 0.5 ) {
-                              bad_cycles[ri]++;
-                         }
-                    }
-               }
-          }
-          
+          QualMetrics qm = GetQualMetrics( qhist );
+          vec<int> bad_cycles = qm.bad_cycles;
+          double max_low_q_base_fraction = qm.max_low_q_base_frac;
+
           // construct format string
           ostringstream msg;
           if ( bad_cycles[0] > 0 )
@@ -407,17 +428,7 @@ int main( int argc, char *argv[] )
           StatLogger::issue_alert("max_low_q_base_frac", max_low_q_base_fraction, format_string);
 
           // % Q30 warning
-          double total = 0, total30 = 0;
-          int max_read_length = qhist[0].size();
-          int max_qual        = qhist[0][0].size();
-          for ( int pos = 0; pos < max_read_length; pos++ ) {
-               for ( int qv = 0; qv != max_qual; qv++ ) {    
-                    total += qhist[1][pos][qv];
-                    if ( qv >= 30 ) total30 += qhist[1][pos][qv];    }
-          }
-          double q30_r2_perc = 0;
-          if ( total > 0 )
-               q30_r2_perc = 100.0 * double(total30) / double(total);
+          double q30_r2_perc = qm.q30_r2_perc;
           StatLogger::issue_alert("q30_r2_perc", q30_r2_perc);
           StatLogger::log("q30_r2_perc", q30_r2_perc, \
                "Percent of bases on read 2 with Q-score >= 30", true );
@@ -535,8 +546,8 @@ int main( int argc, char *argv[] )
      HyperBasevector hbv;
      HyperBasevectorX hb;
      vec<int> inv;
-     ReadPathVec paths;
      ReadPathVecX pathsX;
+     pathsX.setSkip(PATHSX_SKIP);
      vecbasevector genome;
      vec< pair<int,ho_interval> > ambint;
      
@@ -566,22 +577,13 @@ int main( int argc, char *argv[] )
           String dir = work_dir + "/a." + ToString(K);
           Mkdir777( dir );
           // TODO: WAIT
+          // The graph builder paths the reads straight into pathsX.  The
+          // patching stage still wants the uncompressed paths in a.paths.
           StageBuildGraph( MSPEDGES, K, bases, quals_om, MIN_QUAL, MIN_FREQ, MIN_BC,
-                    bc, bc_start, GRAPH, GRAPHMEM, work_dir, read_head,
-                    hbv, paths, inv);
-          
-          // Read in tmp.paths as pathsX here
-          cout << Date( ) << ": reading in paths --> pathsX, mem = "
-               << MemUsageGBString() << endl;
-          {
-               hb = HyperBasevectorX( hbv );
-               const size_t READ_BATCH_SIZE=100000000;
-               InitializePathsXFromPaths( pathsX, hb, work_dir + "/tmp.paths", 
-                    READ_BATCH_SIZE, False );
-               cout << Date( ) << ": done, mem = "
-                    << MemUsageGBString() << endl;
-          }
-          Rename( work_dir + "/tmp.paths", dir + "/a.paths" );
+                    bc, bc_start, GRAPH, GRAPHMEM, GRAPHSPILL, PATHING_PREFETCH_DEPTH,
+                    work_dir, read_head,
+                    hbv, pathsX, dir + "/a.paths", inv);
+          hb.Initialize(hbv);
 
           cout << Date( ) << ": inverting paths index, mem usage = "
                << MemUsageGBString( ) << endl;
@@ -616,8 +618,10 @@ int main( int argc, char *argv[] )
           BinaryReader::readFile( dir + "/a.hbv", &hbv );
           BinaryReader::readFile( dir + "/a.hbx", &hb );
           BinaryReader::readFile( dir + "/a.inv", &inv );
-          cout << Date( ) << ": reading in pathsX" << endl;
-          pathsX.ReadAll( dir + "/a.pathsX" );
+          // The patching stages only read pathsX until TranslatePaths
+          // replaces it, so map it rather than reading it in.
+          cout << Date( ) << ": mapping pathsX" << endl;
+          pathsX.mapBinary( dir + "/a.pathsX" );
           if ( !IsRegularFile( dir + "/a.dup" ) ) {
                cout << Date()  << ": dups file missing, recreating it" << endl;
                VirtualMasterVec<PQVec> vmv( quals_om.filename() );
@@ -637,7 +641,8 @@ int main( int argc, char *argv[] )
           
           StageFindPatch(dir, K, bases, quals_om, hbv, hb, pathsX, paths_index_file,
                     inv, dup, bad, datasets, bc, max_width, ONE_GOOD, closures,
-                    pairs, CG2, STACKSTER, STACKSTER_ALT, RESCUE );
+                    pairs, CG2, STACKSTER, STACKSTER_ALT, RESCUE, PATCH_MAX_READS,
+                    PATCH_MAX_SECONDS, PATCH_STATS );
 
           nonFinalWriter.writeFile( 
                work_dir + "/a." + ToString(K) + "/a.hops", pairs );
@@ -668,11 +673,9 @@ int main( int argc, char *argv[] )
           // Note that presumably we could instead bring in quals as a
           // VirtualMasterVec.
 
-          // NOTE EXPENSIVE CONVERSION!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-          hb = HyperBasevectorX(hbv);
-          Destroy( hbv.FromMutable( ) ), Destroy( hbv.ToMutable( ) );
-          Destroy( hbv.FromEdgeObjMutable( ) ), Destroy( hbv.ToEdgeObjMutable( ) );
-          Destroy( hbv.EdgesMutable( ) );
+          // Convert, freeing each edge of hbv as it is copied; this
+          // leaves hbv empty.
+          hb.Initialize( std::move(hbv) );
           StageExtension( hb, inv, bases, quals_om, pathsX, BACK_EXTEND );
           cout << TimeSince(clock5) << " used in new stuff 5" << endl;
           cout << "now current mem = " << MemUsageGBString( ) << endl;
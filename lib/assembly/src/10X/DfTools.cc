@@ -176,7 +176,7 @@ void WriteSubSample( vecbasevector const& bases, ObjectManager<VecPQVec>& quals_
 }
 
 void LoadData( const String& work_dir, const String& R, const vec<String>& lr,
-     const vec<double>& LR_SELECT_FRAC, vecbasevector& bases,
+     const vec<double>& LR_SELECT_FRAC, const Bool ADOPT_INPUT, vecbasevector& bases,
      ObjectManager<VecPQVec>& quals_om, vec<int64_t>& bci,
      vec<String>& subsam_names, vec<int64_t>& subsam_starts, vec<DataSet>& datasets )
 {
@@ -204,8 +204,33 @@ void LoadData( const String& work_dir, const String& R, const vec<String>& lr,
     
      PRINTDEETS("load reads");
      String const& OUT_HEAD = work_dir + "/data/frag_reads_orig";
+
+     // An earlier run with ADOPT_INPUT may have left these names as links to
+     // the input files.  Unlink them before anything is written under them, as
+     // opening a link for writing would truncate the input.
+
+     for ( char const* ext : { ".fastb", ".qualp", ".bci" } )
+          Remove( OUT_HEAD + ext );
      
-     if ( lr.size() == 1 ) {
+     if ( lr.size() == 1 && ADOPT_INPUT ) {
+        // if it's only one file, adopt it in place -- no copying
+        String head = lr[0].Before(".fastb");
+        PRINTDEETS("short pipeline path, adopting " << head);
+        for ( char const* ext : { ".fastb", ".qualp", ".bci" } ) {
+             String how = AdoptFile( head + ext, OUT_HEAD + ext );
+             PRINTDEETS("  " << how << " " << OUT_HEAD + ext);
+        }
+        bases.ReadAll(OUT_HEAD+".fastb");
+        ForceAssertEq(quals_om.filename(), OUT_HEAD+".qualp");
+        quals.ReadAll(OUT_HEAD+".qualp");
+        BinaryReader::readFile(OUT_HEAD+".bci", &bci);
+
+        datasets.push_back( { ReadDataType::UNBAR_10X, bci[0] } );   // UNBAR is [ bci[0], bci[1] )
+        if ( bci.size() > 2 ) {                                      // BAR is [ bci[1], bci[2] )
+             // something rather wrong if we don't get here...
+             datasets.push_back( { ReadDataType::BAR_10X, bci[1] } );
+        }
+     } else if ( lr.size() == 1 ) {
         // if it's only one file, just read it
         String head = lr[0].Before(".fastb");
         PRINTDEETS("short pipeline path, reading from " << head);
@@ -324,7 +349,7 @@ void LoadData( const String& work_dir, const String& R, const vec<String>& lr,
 }
 
 void GetQualStats( const VecPQVec& quals, vec<vec<vec<int64_t>>>& hist, 
-                   int & max_read_length )
+                   int & max_read_length, GoodLens* good_lens )
 { 
      const int64_t N = quals.size( );
      const int T = omp_get_max_threads( );
@@ -336,6 +361,7 @@ void GetQualStats( const VecPQVec& quals, vec<vec<vec<int64_t>>>& hist,
      
      // create the data structure
      hist.resize( 2, vec<vec<int64_t>>( max_read_length, vec<int64_t>(256, 0) ) );
+     if ( good_lens ) ForceAssertEq( good_lens->size( ), quals.size( ) );
      
      { // open block to kill temp data structure
 
@@ -345,14 +371,15 @@ void GetQualStats( const VecPQVec& quals, vec<vec<vec<int64_t>>>& hist,
      for ( int t = 0; t < T; t++ ) {
           const int64_t start = batch*t;
           const int64_t stop  = Min( batch*(t+1), N );
+          qualvector q;
           for ( int64_t id = start; id < stop; id++ ) {
-               qualvector q;
                quals[id].unpack( &q );
                int pos = 0;
                for ( auto x : q ) {
                     hist_part[t][id%2][pos][x]++;
                     pos++;
                }
+               if ( good_lens ) good_lens->set( id, q );
           }
      }
      
@@ -391,6 +418,43 @@ void GetQualStats( const VecPQVec& quals, vec<vec<vec<int64_t>>>& hist,
      
 }
 
+QualMetrics GetQualMetrics( const vec<vec<vec<int64_t>>>& hist )
+{
+     // Compute whether we have a cycle failure
+     // defined as 50 % or greater of the reads 
+     // having a base with Q <= 2 at a fixed cycle
+     QualMetrics m;
+     const int MIN_READS = 1000; // only alert if we have at least 1000 reads 
+     for ( int ri = 0; ri != 2; ri++ ) {
+          for ( int pos = 0; pos != int(hist[ri].size()); pos++ ) {
+               float low_q=0.0, all_q=0.0;
+               for ( int q = 0; q != int(hist[ri][pos].size()); q++ ) {
+                    if ( q <= 2 )
+                         low_q += hist[ri][pos][q];
+                    all_q += hist[ri][pos][q];
+               }
+               if ( all_q > MIN_READS ) {
+                    if ( m.max_low_q_base_frac < low_q/all_q ) 
+                         m.max_low_q_base_frac = low_q/all_q;
+                    if ( low_q/all_q > 0.5 ) {
+                         m.bad_cycles[ri]++;
+                    }
+               }
+          }
+     }
+
+     // % Q30 on read two
+     double total = 0, total30 = 0;
+     for ( int pos = 0; pos < int(hist[1].size()); pos++ ) {
+          for ( int qv = 0; qv != int(hist[1][pos].size()); qv++ ) {    
+               total += hist[1][pos][qv];
+               if ( qv >= 30 ) total30 += hist[1][pos][qv];    }
+     }
+     if ( total > 0 )
+          m.q30_r2_perc = 100.0 * double(total30) / double(total);
+     return m;
+}
+
 void FragDist( const HyperBasevectorX& hb, const vec<int>& inv,
      const ReadPathVec& paths, vec<int64_t>& count )
 {    const int max_sep = 1000;
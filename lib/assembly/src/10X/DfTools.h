@@ -15,6 +15,7 @@
 #include "feudal/PQVec.h"
 #include "feudal/BinaryStream.h"
 #include "paths/HyperBasevector.h"
+#include "paths/long/GoodLens.h"
 #include "paths/long/ReadPath.h"
 #include "10X/LogEntry.h"
 #include "10X/Martian.h"
@@ -434,13 +435,35 @@ template<int K> void MapClosures( const HyperBasevectorX& hb,
 vec<int> GetBarcodes( const int e, const vec<int>& inv,
      const VecULongVec& paths_index, const vec<int>& bc );
 
+// Load the reads into data/frag_reads_orig.{fastb,qualp,bci}.  If there is a
+// single LR input and ADOPT_INPUT is set, its files are linked in place (see
+// AdoptFile) rather than rewritten.  Existing files under those names are
+// removed first, so that a rerun never writes through links left by an earlier
+// adopting run.
+
 void LoadData( const String& work_dir, const String& R, const vec<String>& lr,
-     const vec<double>& LR_SELECT_FRAC, vecbasevector& bases,
+     const vec<double>& LR_SELECT_FRAC, const Bool ADOPT_INPUT, vecbasevector& bases,
      ObjectManager<VecPQVec>& quals_om, vec<int64_t>& bci,
      vec<String>& subsam_names, vec<int64_t>& subsam_starts, vec<DataSet>& datasets);
 
-void GetQualStats( 
-     const VecPQVec& quals, vec<vec<vec<int64_t>>> & hist, int & max_read_length);
+// Compute the quality histogram hist, indexed by read in pair, cycle and qual,
+// in one pass over the quals.  If good_lens is given (sized to the quals, with
+// its parameters set), the good length of each read is filled in too.
+
+void GetQualStats( const VecPQVec& quals, vec<vec<vec<int64_t>>> & hist,
+     int & max_read_length, GoodLens* good_lens = nullptr );
+
+// Quality metrics reported by DF, derived from the histogram: the number of
+// cycles on each read at which most bases have Q <= 2, the largest fraction of
+// such bases at any cycle, and the percent of bases on read two that are Q30+.
+
+struct QualMetrics {
+     vec<int> bad_cycles = vec<int>(2, 0);
+     double max_low_q_base_frac = 0.0;
+     double q30_r2_perc = 0.0;
+};
+
+QualMetrics GetQualMetrics( const vec<vec<vec<int64_t>>>& hist );
 
 void FragDist( const HyperBasevectorX& hb, const vec<int>& inv,
      const ReadPathVec& paths, vec<int64_t>& count );
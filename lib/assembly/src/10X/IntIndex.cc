@@ -26,105 +26,54 @@ void IntIndex::Initialize(
 
      big_ = ( paths.size( ) > 4294967296l );
 
-     // Count elements.
+     // Count elements, for each batch of reads.  Then turn the batch counts
+     // into the place in each edge's values where the batch starts.  The
+     // counts are kept through the scatter, alongside the values, so there is
+     // a batch per thread but no more than ten, unless there are enough reads
+     // per edge that the counts stay small next to the values.
 
      if (verbose) cout << Date( ) << ": creating an index" << endl;
      double clock = WallClockTime( );
      int64_t N = paths.size( );
+     const int64_t max_batches = Max( (int64_t) 10, N / ( 4 * Max( NE, 1 ) ) );
+     const int64_t batches = Max( (int64_t) 1,
+          Min( (int64_t) omp_get_max_threads( ), max_batches ) );
+     vec<vec<int>> counti( batches, vec<int>( NE, 0 ) );
+     #pragma omp parallel for schedule( dynamic, 1 )
+     for ( int b = 0; b < batches; b++ )
+     for ( int64_t id = (b*N)/batches; id < ((b+1)*N)/batches; id++ )
+     {    const ReadPath& p = paths[id];
+          for ( auto e : p ) counti[b][e]++;    }
      vec<int> count( NE, 0 );
-     {    const int64_t batches = 10;
-          vec<vec<int>> counti( batches, vec<int>( NE, 0 ) );
-          #pragma omp parallel for schedule( dynamic, 1 )
-          for ( int b = 0; b < batches; b++ )
+     #pragma omp parallel for
+     for ( int e = 0; e < NE; e++ )
+     for ( int t = 0; t < batches; t++ )
+     {    int c = counti[t][e];
+          counti[t][e] = count[e];
+          count[e] += c;    }
+
+     // Find estarts and allocate space.
+
+     index_.resize( NE + 1 );
+     index_[0] = 0;
+     for ( int e = 0; e < NE; e++ )
+          index_[e+1] = index_[e] + count[e];
+     Destroy(count);
+     if ( !big_ ) core_.resize( index_[NE] );
+     else core_big_.resize( index_[NE] );
+
+     // Shovel data.  Each batch fills its own slots, in read order, so the
+     // values for each edge come out sorted.
+
+     #pragma omp parallel for schedule( dynamic, 1 )
+     for ( int b = 0; b < batches; b++ )
+     {    vec<int>& pos = counti[b];
           for ( int64_t id = (b*N)/batches; id < ((b+1)*N)/batches; id++ )
           {    const ReadPath& p = paths[id];
-               for ( auto e : p ) counti[b][e]++;    }
-          #pragma omp parallel for
-          for ( int e = 0; e < NE; e++ )
-          for ( int t = 0; t < batches; t++ )
-               count[e] += counti[t][e];    }
-
-     // Set up.
-
-     const int64_t sbatch = 20000;
-     vec<vec<int>> start;
-
-     // Run in parallel.
-
-     #pragma omp parallel sections
-     {
-          // Find estarts.
-
-          #pragma omp section
-          {    index_.resize( NE + 1 );
-               index_[0] = 0;
-               for ( int e = 0; e < NE; e++ )
-                    index_[e+1] = index_[e] + count[e];    }
-     
-          // Allocate space.
-     
-          #pragma omp section
-          {    int64_t total = BigSum(count);
-               if ( !big_ ) core_.resize(total);
-               else core_big_.resize(total);    }
-     
-          // Find starts.
-     
-          #pragma omp section
-          {    int sbatches = 0;
-               for ( int64_t bi = 0; bi < (int64_t) paths.size( ); bi += sbatch )
-                    sbatches++;
-               start.resize(sbatches);
-               #pragma omp parallel for
-               for ( int64_t bi = 0; bi < (int64_t) paths.size( ); bi += sbatch )
-               {    int bid = bi/sbatch;
-                    int nb = Min( sbatch, (int64_t) paths.size( ) - bi );
-                    start[bid].resize( nb+1, 0 );
-                    for ( int j = 0; j < nb; j++ )
-                    {    start[bid][j+1] = start[bid][j] 
-                              + paths[bi+j].size( );    }    }    }    }
-
-     // Shovel data.
-
-     vec<int> pos( NE, 0 );
-     for ( int64_t bi = 0; bi < (int64_t) paths.size( ); bi += sbatch )
-     {    int bid = bi/sbatch, nb = Min( sbatch, (int64_t) paths.size( ) - bi );
-          vec< pair<int,int64_t> > D( start[bid].back( ) );
-          #pragma omp parallel for
-          for ( int j = 0; j < nb; j++ )
-          {    const ReadPath& p = paths[bi+j];
-               for ( int l = 0; l < (int) p.size( ); l++ )
-               {    D[ start[bid][j] + l ] = make_pair( p[l], bi+j );    }    }
-          ParallelSort(D);    
-          int nd = 2 * omp_get_max_threads( );
-          vec<int64_t> dstarts(nd+1);
-          for ( int64_t j = 0; j <= nd; j++ )
-               dstarts[j] = ( j * D.jsize( ) ) / nd;
-          for ( int j = 0; j < nd; j++ )
-          {    while( dstarts[j] > 0 
-                    && D[ dstarts[j] ].first == D[ dstarts[j] - 1 ].first )
-               {     dstarts[j]--;    }    }
-
-          // Move the data.
-
-          if ( !big_ )
-          {
-               #pragma omp parallel for schedule( dynamic, 1 )
-               for ( int b = 0; b < nd; b++ )
-               {    for ( int64_t m = dstarts[b]; m < dstarts[b+1]; m++ )
-                    {    int e = D[m].first;
-                         int64_t id = D[m].second;
-                         core_[ index_[e] + pos[e] ] = id;
-                         pos[e]++;    }    }    }
-          else
-          {    
-               #pragma omp parallel for schedule( dynamic, 1 )
-               for ( int b = 0; b < nd; b++ )
-               {    for ( int64_t m = dstarts[b]; m < dstarts[b+1]; m++ )
-                    {    int e = D[m].first;
-                         int64_t id = D[m].second;
-                         core_big_[ index_[e] + pos[e] ] = id;
-                         pos[e]++;    }    }    }    }
+               for ( auto e : p )
+               {    if ( !big_ ) core_[ index_[e] + pos[e] ] = id;
+                    else core_big_[ index_[e] + pos[e] ] = id;
+                    pos[e]++;    }    }    }
 
      if (verbose)
      {    cout << Date( ) << ": " << TimeSince(clock) << " used indexing" 
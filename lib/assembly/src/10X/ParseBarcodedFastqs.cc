@@ -19,11 +19,18 @@
 #include "feudal/PQVec.h"
 #include "kmers/KmerRecord.h"
 #include "feudal/BinaryStream.h"
+#include "feudal/FeudalControlBlock.h"
+#include "feudal/FeudalFileSplicer.h"
 #include "feudal/IncrementalWriter.h"
-#include "feudal/VirtualMasterVec.h"
+#include "system/LockedData.h"
+#include "system/SysConf.h"
+#include <atomic>
 #include <fstream>
+#include <list>
 #include <string>
 #include <array>
+#include <thread>
+#include <vector>
 
 namespace {
 
@@ -53,24 +60,91 @@ bool hasGemGroup( String const& s )
 }
 
 
-void newUnpackBarcodeSortedFastq( const String& file, vecbasevector& b0_bases,
-          VecPQVec& b0_quals, vecbasevector& bc_bases, VecPQVec& bc_quals,
-          vec<uint32_t>& bcs )
+// A batch of read pairs parsed from one input file, in file order.  Each pair
+// is tagged as unbarcoded, as continuing the barcode of the previous barcoded
+// pair, or as starting a new barcode.
+struct FastqChunk
+{
+     enum Tag : unsigned char { UNBARCODED, SAME_BARCODE, NEW_BARCODE };
+
+     void clear() { bases.clear(); quals.clear(); tags.clear(); bytes = 0; }
+
+     void swap( FastqChunk& that )
+     {    bases.swap(that.bases); quals.swap(that.quals);
+          tags.swap(that.tags); std::swap(bytes,that.bytes);    }
+
+     vecbasevector bases;     // two reads per pair
+     VecPQVec quals;          // two quals per pair
+     vec<unsigned char> tags; // one Tag per pair
+     size_t bytes = 0;        // rough memory footprint, for buffer accounting
+};
+
+// Hands FastqChunks from the parsing threads to the writing thread.  The
+// writer consumes the files strictly in order.  A parser blocks while the
+// total buffered data exceeds the budget, unless it is parsing the file the
+// writer is waiting on and that file has nothing buffered, so progress is
+// always possible and memory use is bounded by the budget plus one chunk per
+// parser.
+class FastqChunkQueue
+{
+public:
+     FastqChunkQueue( size_t nFiles, size_t maxBytes )
+     : mCond(mLock), mQueues(nFiles), mDone(nFiles,False), mCurFile(0),
+       mBytes(0), mMaxBytes(maxBytes) {}
+
+     void push( size_t fileIdx, FastqChunk& chunk )
+     {    Locker lock(mLock);
+          while ( mBytes >= mMaxBytes &&
+                    !(fileIdx == mCurFile && mQueues[fileIdx].empty()) )
+               lock.wait(mCond);
+          mBytes += chunk.bytes;
+          mQueues[fileIdx].emplace_back();
+          mQueues[fileIdx].back().swap( chunk );
+          mCond.broadcast( );    }
+
+     void setDone( size_t fileIdx )
+     {    Locker lock(mLock);
+          mDone[fileIdx] = True;
+          mCond.broadcast( );    }
+
+     // Returns false when fileIdx is finished and completely drained.
+     bool pop( size_t fileIdx, FastqChunk* pChunk )
+     {    Locker lock(mLock);
+          if ( mCurFile != fileIdx ) { mCurFile = fileIdx; mCond.broadcast( ); }
+          while ( mQueues[fileIdx].empty() && !mDone[fileIdx] )
+               lock.wait(mCond);
+          if ( mQueues[fileIdx].empty() ) return false;
+          pChunk->swap( mQueues[fileIdx].front() );
+          mQueues[fileIdx].pop_front();
+          mBytes -= pChunk->bytes;
+          mCond.broadcast( );
+          return true;    }
+
+private:
+     LockedData mLock;
+     Condition mCond;
+     vec<std::list<FastqChunk>> mQueues;
+     vec<Bool> mDone;
+     size_t mCurFile;
+     size_t mBytes;
+     size_t mMaxBytes;
+};
+
+void parseBarcodedFastq( const String& file, size_t fileIdx,
+          FastqChunkQueue& queue, size_t chunkPairs )
 {
      // TODO: work for non-gzipped
      ForceAssert(file.EndsWith(".fastq.gz") || file.EndsWith(".fasth.gz"));
 
-     cout << Date() << ": " << file << endl;
-
      String buf;
      fast_pipe_ifstream input( "zcat " + file );
      enum { START, READ1, QUAL1, READ2, QUAL2, BARC, QUALBARC, INDEX, QUALINDEX, END };
      array<basevector,2> btmp;
      array<qualvector,2> qtmp;
-     uint32_t barc = bcs.size() ? bcs.back() : 0u;
      String lastb;
      size_t line = 0;
      std::map<String,size_t> seen;
+     FastqChunk chunk;
 
      while ( 1 ) {
           try {
@@ -100,35 +174,36 @@ void newUnpackBarcodeSortedFastq( const String& file, vecbasevector& b0_bases,
                          case QUAL2:
                               convertPhred( buf, qtmp[1] );
                               break;
-                         case BARC:
+                         case BARC: {
                               // lack of a gem group indicates failing barcode
                               // presence of a gem group, but lack of a barcode indicates no barcode read
                               // AND no whitelist.  Treat them the same.
+                              unsigned char tag = FastqChunk::UNBARCODED;
                               if ( hasGemGroup( buf ) && buf[0] != '-' ) {
                                    buf = buf.SafeBefore(",");              // new FASTH format has un-corrected barcode after the comma
+                                   tag = FastqChunk::SAME_BARCODE;
                                    if ( lastb != buf ) {    // should trigger 1st time
-                                        barc++;             // ...so 1st bc is 1
+                                        tag = FastqChunk::NEW_BARCODE;
                                         lastb = buf;
                                         if ( seen.count(buf) > 0 ) {
                                              cout  << "barcode " << buf << " at line " << line << " already seen at line "  << seen[buf] << endl;
                                         }
                                         seen[buf]=line;
-//                                        PRINT3( barc, seen.size(), buf );
                                    }
-                                   bcs.push_back(barc);
-                                   bcs.push_back(barc);
-                                   bc_bases.push_back( btmp[0] );
-                                   bc_bases.push_back( btmp[1] );
-                                   bc_quals.push_back( PQVec( qtmp[0] ) );
-                                   bc_quals.push_back( PQVec( qtmp[1] ) );
-                              } else {
-                                   b0_bases.push_back( btmp[0] );
-                                   b0_bases.push_back( btmp[1] );
-                                   b0_quals.push_back( PQVec( qtmp[0] ) );
-                                   b0_quals.push_back( PQVec( qtmp[1] ) );
                               }
-
+                              chunk.tags.push_back( tag );
+                              for ( int j = 0; j < 2; ++j ) {
+                                   chunk.bases.push_back( btmp[j] );
+                                   chunk.quals.push_back( PQVec( qtmp[j] ) );
+                                   chunk.bytes += btmp[j].size()/4 + qtmp[j].size()/2
+                                        + sizeof(basevector) + sizeof(PQVec);
+                              }
+                              if ( chunk.tags.size() >= chunkPairs ) {
+                                   queue.push( fileIdx, chunk );
+                                   chunk.clear();
+                              }
                               break;
+                         }
                          case QUALBARC:
                          case INDEX:
                          case QUALINDEX:
@@ -138,11 +213,110 @@ void newUnpackBarcodeSortedFastq( const String& file, vecbasevector& b0_bases,
                }
 
           } catch ( ParseError const& e ) {
-               FatalErr( "out of sync reading line: " + string(e.what()) );
+               FatalErr( "out of sync reading " + file + " line "
+                         + ToString(line) + ": " + string(e.what()) );
           } catch ( EndOfFile const& e ) {
                break;
           }
      }
+     if ( chunk.tags.size() ) queue.push( fileIdx, chunk );
+     queue.setDone( fileIdx );
+}
+
+// Parse the barcode-sorted fastqs on up to nThreads threads, streaming reads
+// to OUT_HEAD.{fastb,qualp,bci} as they arrive.  Files are decompressed and
+// parsed concurrently, but written in the order given.  Since the unbarcoded
+// reads have to come first in the output, they and the barcoded reads are
+// spooled to separate temporary files that are spliced together at the end.
+// The amount of parsed data held in memory is bounded by bufferBytes.
+// We're assuming that barcodes are not split across files.
+void ingestBarcodedFastqs( vec<String> const& fastqs, String const& OUT_HEAD,
+          size_t nThreads, size_t bufferBytes )
+{
+     size_t const CHUNK_PAIRS = 50000;
+
+     String const b0_head = OUT_HEAD + ".b0.tmp";
+     String const bc_head = OUT_HEAD + ".bc.tmp";
+     FastqChunkQueue queue( fastqs.size(), bufferBytes );
+     std::atomic<size_t> nextFile(0);
+     nThreads = std::max( 1ul, std::min( nThreads, fastqs.size() ) );
+     cout << Date() << ": parsing " << fastqs.size() << " file(s) using "
+          << nThreads << " thread(s)" << endl;
+
+     std::vector<std::thread> parsers;
+     for ( size_t t = 0; t < nThreads; ++t )
+          parsers.emplace_back( [&]() {
+               size_t fileIdx;
+               while ( (fileIdx = nextFile++) < fastqs.size() ) {
+                    cout << Date() << ": " << fastqs[fileIdx] << endl;
+                    parseBarcodedFastq( fastqs[fileIdx], fileIdx, queue,
+                              CHUNK_PAIRS );
+               }
+          } );
+
+     // barcode bc starts at bc_starts[bc-1] within the barcoded reads
+     vec<int64_t> bc_starts;
+     int64_t b0_size = 0, bc_size = 0;
+     {
+          IncrementalWriter<basevector> b0_bases( b0_head + ".fastb" );
+          IncrementalWriter<PQVec>      b0_quals( b0_head + ".qualp" );
+          IncrementalWriter<basevector> bc_bases( bc_head + ".fastb" );
+          IncrementalWriter<PQVec>      bc_quals( bc_head + ".qualp" );
+          FastqChunk chunk;
+          for ( size_t fileIdx = 0; fileIdx < fastqs.size(); ++fileIdx ) {
+               while ( queue.pop( fileIdx, &chunk ) ) {
+                    for ( size_t i = 0; i < chunk.tags.size(); ++i ) {
+                         if ( chunk.tags[i] == FastqChunk::UNBARCODED ) {
+                              b0_bases.add( chunk.bases[2*i] );
+                              b0_bases.add( chunk.bases[2*i+1] );
+                              b0_quals.add( chunk.quals[2*i] );
+                              b0_quals.add( chunk.quals[2*i+1] );
+                              b0_size += 2;
+                         } else {
+                              if ( chunk.tags[i] == FastqChunk::NEW_BARCODE )
+                                   bc_starts.push_back( bc_size );
+                              bc_bases.add( chunk.bases[2*i] );
+                              bc_bases.add( chunk.bases[2*i+1] );
+                              bc_quals.add( chunk.quals[2*i] );
+                              bc_quals.add( chunk.quals[2*i+1] );
+                              bc_size += 2;
+                         }
+                    }
+               }
+          }
+     }
+     for ( auto& t : parsers ) t.join();
+
+     cout << Date() << ": writing output to " + OUT_HEAD + " .fastb,.qualp,.bci " << endl;
+     {
+          TypedFeudalFileSplicer<basevector> bases_out( OUT_HEAD + ".fastb" );
+          TypedFeudalFileSplicer<PQVec>      quals_out( OUT_HEAD + ".qualp" );
+          for ( String const& head : { b0_head, bc_head } ) {
+               bases_out.add( head + ".fastb" );
+               quals_out.add( head + ".qualp" );
+          }
+          bases_out.write();
+          quals_out.write();
+     }
+     for ( String const& head : { b0_head, bc_head } ) {
+          Remove( head + ".fastb" );
+          Remove( head + ".qualp" );
+     }
+
+     vec<int64_t> bci;
+     bci.push_back(0);
+     for ( int64_t start : bc_starts )
+          bci.push_back( b0_size + start );
+     bci.push_back( b0_size + bc_size );
+     BinaryWriter::writeFile( OUT_HEAD + ".bci", bci ) ;
+
+     // barcode stats
+     size_t count = 0;
+     for ( size_t i = 1; i < bci.size()-1; ++i )  {
+          if ( bci[i+1] - bci[i] > 10 ) count++;
+     }
+     cout << Date() << ": " << count << " barcodes have more than 10 reads, out of a total of "
+          << bci.size()-2 << " barcodes" << endl;
 }
 
 
@@ -170,71 +344,71 @@ void mergeBarcodedReadFiles( vec<String> const& MERGE_HEADS, String const& OUT_H
           else merge_heads.push_back( merge_head );
      }
 
-     // create output files
-     BinaryIteratingWriter<vec<int64_t>>     bci_out( OUT_HEAD + ".bci" );
-     IncrementalWriter<basevector>           bases_out( OUT_HEAD + ".fastb" );
-     IncrementalWriter<PQVec>                quals_out( OUT_HEAD + ".qualp" );
-
-     // two passes -- do zero bc first because they must be aggregated.
-     // all other files are assumed to have unique barcodes
+     // the reads are spliced in bulk, straight from the input files.  zero bc
+     // reads go first because they must be aggregated.  all other files are
+     // assumed to have unique barcodes.  only the .bci needs rewriting.
+     TypedFeudalFileSplicer<basevector> bases_out( OUT_HEAD + ".fastb" );
+     TypedFeudalFileSplicer<PQVec>      quals_out( OUT_HEAD + ".qualp" );
+     vec<vec<int64_t>> bcis( merge_heads.size() );
      size_t count = 0;
-     uint32_t bc_bias = 0;
-     bci_out.write(0u);
 
      for (unsigned pass = 0; pass <=1; ++pass ) {
-          for ( std::string merge_head : merge_heads ) {
-
-               cout << Date() << ": pass " << pass+1 << " (of 2): " << merge_head << endl;
-
-               VirtualMasterVec<basevector> bases( merge_head + ".fastb" );
-               VirtualMasterVec<PQVec> quals( merge_head + ".qualp" );
-               vec<int64_t> bci; BinaryReader::readFile( merge_head + ".bci", &bci );
-
-               ForceAssertEq( bases.size(), quals.size() );
-               ForceAssertEq( bases.size(), bci.back() );
-
-               if ( bases.size() == 0 ) continue;
-
-               for ( size_t i = 1; i < bci.size(); ++i )
-                    if ( bci[i] < bci[i-1] ) {
-                         cout << "barcode indices are out of order" << endl;
-                         PRINT2(bci[i], bci[i-1]);
-                    }
+          for ( size_t h = 0; h < merge_heads.size(); ++h ) {
+               String const& merge_head = merge_heads[h];
+               vec<int64_t>& bci = bcis[h];
+               size_t zero_count;
 
                if ( pass == 0 ) {
-                    size_t this_count = bci[1];
-                    for ( size_t i = 0; i < this_count; ++i ) {
-                         bases_out.add( bases[i] );
-                         quals_out.add( quals[i] );
-                    }
+                    cout << Date() << ": " << merge_head << endl;
+                    BinaryReader::readFile( merge_head + ".bci", &bci );
+                    size_t nbases = FeudalControlBlock(
+                                   (merge_head + ".fastb").c_str() ).getNElements();
+                    size_t nquals = FeudalControlBlock(
+                                   (merge_head + ".qualp").c_str() ).getNElements();
+                    ForceAssertEq( nbases, nquals );
+                    ForceAssertEq( nbases, bci.back() );
+                    if ( nbases == 0 ) { bci.clear(); continue; }
 
-                    count += this_count;
+                    for ( size_t i = 1; i < bci.size(); ++i )
+                         if ( bci[i] < bci[i-1] ) {
+                              cout << "barcode indices are out of order" << endl;
+                              PRINT2(bci[i], bci[i-1]);
+                         }
+
+                    zero_count = bci[1];
+                    bases_out.add( merge_head + ".fastb", 0, zero_count );
+                    quals_out.add( merge_head + ".qualp", 0, zero_count );
+                    count += zero_count;
                } else {
-                    size_t zero_count = bci[1];
+                    if ( bci.empty() ) continue;
+                    zero_count = bci[1];
+                    size_t nbases = bci.back();
+                    bases_out.add( merge_head + ".fastb", zero_count, nbases );
+                    quals_out.add( merge_head + ".qualp", zero_count, nbases );
 
                     // increment all of the offsets
                     ForceAssertGe( count, zero_count );
-
                     for ( size_t i = 1; i < bci.size(); ++i )
                          bci[i] = bci[i] - zero_count + count;
-
-                    // write all reads and barcodes past bc0
-                    for ( size_t i = zero_count; i < bases.size(); ++i )  {
-                         bases_out.add( bases[i] );
-                         quals_out.add( quals[i] );
-                    }
-
-                    for ( size_t i=1; i < bci.size()-1; ++i )
-                         bci_out.write( bci[i] );
-
-                    count += bases.size() - zero_count;
+                    count += nbases - zero_count;
                }
           }
-
-          if ( pass == 1 ) bci_out.write( count );
      }
-}
 
+     cout << Date() << ": splicing " << count << " reads into " << OUT_HEAD
+          << ".{fastb,qualp}" << endl;
+     ForceAssertEq( bases_out.getNElements(), count );
+     bases_out.write();
+     quals_out.write();
+
+     BinaryIteratingWriter<vec<int64_t>> bci_out( OUT_HEAD + ".bci" );
+     bci_out.write(0u);
+     for ( auto const& bci : bcis )
+          for ( size_t i=1; i+1 < bci.size(); ++i )
+               bci_out.write( bci[i] );
+     bci_out.write( count );
+     bci_out.close();
+}
 
 };
 
@@ -250,6 +424,10 @@ int main(int argc, char *argv[])
      CommandArgument_String_Doc(OUT_HEAD, "basename of output files {.fastb, .qualp, .bc, .bci}");
      CommandArgument_StringSet_OrDefault_Doc(MERGE_HEADS, "",
                "list of heads for fastb/qualp/bc/bci files to merge, rather than produce" );
+     CommandArgument_UnsignedInt_OrDefault_Doc(NUM_THREADS, 0,
+               "number of fastq files to decompress and parse at once; 0 means use all processors" );
+     CommandArgument_UnsignedInt_OrDefault_Doc(BUFFER_MB, 4096,
+               "bound on the parsed read data held in memory, in MB" );
      EndCommandArguments;
 
      // Define data structures.
@@ -273,42 +451,9 @@ int main(int argc, char *argv[])
                else fastqs.push_back(file);
 
 
-          // we're assuming that barcodes are not split across files
-          vecbasevector bc_bases,b0_bases;
-          VecPQVec bc_quals,b0_quals;
-          vec<uint32_t> bcs;
-          for ( auto const& file : FASTQS )
-               newUnpackBarcodeSortedFastq( file, b0_bases, b0_quals, bc_bases, bc_quals, bcs );
-
-
-          vec<int64_t> bci;
-          bci.push_back(0);
-          int64_t b0_size = b0_bases.size();
-          int64_t cur = 0;
-          for (size_t i = 0; i < bcs.size(); ++i )
-               if ( bcs[i] != cur ) {        // bcs should start != 0, so we cover the end of 0 here
-                    cur = bcs[i];
-                    bci.push_back(i+b0_size);
-               }
-          bci.push_back(b0_size+bcs.size());
-
-
-          cout << Date() << ": writing output to " + OUT_HEAD + " .fastb,.qualp,.bci " << endl;
-          IncrementalWriter<basevector> bases_out( OUT_HEAD + ".fastb" );
-          IncrementalWriter<PQVec>      quals_out( OUT_HEAD + ".qualp" );
-          bases_out.add( b0_bases.begin(), b0_bases.end() );
-          bases_out.add( bc_bases.begin(), bc_bases.end() );
-          quals_out.add( b0_quals.begin(), b0_quals.end() );
-          quals_out.add( bc_quals.begin(), bc_quals.end() );
-          BinaryWriter::writeFile( OUT_HEAD + ".bci", bci ) ;
-
-          // barcode stats
-          size_t count = 0;
-          for ( size_t i = 1; i < bci.size()-1; ++i )  {
-               if ( bci[i+1] - bci[i] > 10 ) count++;
-          }
-          cout << Date() << ": " << count << " barcodes have more than 10 reads, out of a total of "
-               << bci.size()-2 << " barcodes" << endl;
+          ingestBarcodedFastqs( fastqs, OUT_HEAD,
+                    NUM_THREADS ? NUM_THREADS : processorsOnline(),
+                    size_t(BUFFER_MB) << 20 );
 
           // Done.
      }
@@ -5,120 +5,228 @@
 #include "10X/PathsIndex.h"
 #include <omp.h>
 #include "10X/DfTools.h"
+#include "feudal/FeudalFileWriter.h"
+#include "system/SpinLockedData.h"
 
 /* Approach to inversion:
- * Split step:
- * Split the set of edges in hbv into chunks.
- * Go through paths and create a temporary file for each chunk
- * that stores {(edge, read id) for each edge in chunk}
- * Process chunk:
- * Read in each temporary file. Sort the {(edge, read id)} vector.
- * Use a Parallel sort. Read id's that belong to the same edge
- * are now consecutive entries. 
- * write out the final paths_index file.
+ * Count step:
+ * Go through paths in parallel and count the number of (edge, read id)
+ * pairs for each edge.  These counts are the countsb vector, and they
+ * give the offsets of a CSR (edge -> read ids) layout.
+ * In memory, if the CSR fits in the memory budget:
+ * Go through paths in parallel a second time and scatter each read id
+ * into its edge's slot.  Sort each edge's read ids, then write out the
+ * final paths_index file one contiguous block per edge.
+ * Out of core, otherwise:
+ * Split the edges into partitions of roughly equal pair counts, each
+ * small enough to invert in memory.  Go through paths in parallel and
+ * spill (edge, read id) pairs into a temporary file per partition.
+ * Read back and invert each partition as above, in edge order.
  */
 // NEW: Also write a counts vector that measure the total read support
 
+namespace {
 
-void writePathsIndex( ReadPathVec & paths, vec<int> & inv,
-                      String base_dir, String pi_file = "a.paths.inv",
-                      String counts_file = "a.countsb",
-                      const int chunks = 15, bool verbose=false )
+// Adapters that call fn( id, path ) for every read, from many threads.
+
+struct ForEachPath
+{
+     ReadPathVec const& paths;
+
+     template <class Fn>
+     void operator()( Fn fn ) const
+     {
+          const int64_t N = paths.size( );
+          #pragma omp parallel for schedule(dynamic, 10000)
+          for ( int64_t id = 0; id < N; id++ )
+               fn( id, paths[id] );
+     }
+};
+
+struct ForEachPathX
+{
+     ReadPathVecX const& paths;
+     HyperBasevectorX const& hb;
+
+     template <class Fn>
+     void operator()( Fn fn ) const
+     {    paths.forEachPath( hb, 0, paths.size( ), fn );    }
+};
+
+typedef pair<int, unsigned long> EdgeRead;
+
+// Pairs buffered per thread and partition before a spill file is locked.
+size_t const SPILL_BUFFER = 1024;
+// Keep the number of open spill files reasonable, whatever the budget.
+int const MAX_PARTS = 512;
+
+// Sort the read ids of each edge in [ebegin,eend), which lie at
+// ids[off[e],off[e+1]).
+
+void sortEdgeRange( vec<unsigned long> & ids, vec<uint64_t> const& off,
+                    const int ebegin, const int eend )
+{
+     #pragma omp parallel for schedule(dynamic, 1000)
+     for ( int e = ebegin; e < eend; e++ )
+          std::sort( ids.begin( ) + off[e], ids.begin( ) + off[e+1] );
+}
+
+void writeEdgeRange( FeudalFileWriter & piw, vec<unsigned long> const& ids,
+                     vec<uint64_t> const& off, const int ebegin, const int eend )
+{
+     ULongVec::size_type n;
+     for ( int e = ebegin; e < eend; e++ ) {
+          unsigned long const* data = ids.data( ) + off[e];
+          n = off[e+1] - off[e];
+          piw.getWriter( ).write( data, data + n );
+          piw.addElement( &n );
+     }
+}
+
+template <class ForEach>
+void invertPaths( ForEach forEach, vec<int> const& inv, String const& base_dir,
+                  String const& pi_file, String const& counts_file,
+                  const int chunks, bool verbose )
 {
-     cout << Date( ) << ": inverting paths" << endl;
      const int num_edges = inv.size();
      ForceAssertGt( num_edges, 0 );
      ForceAssertGt( chunks, 0 );
-     const int chunk_size = num_edges/chunks + 1;
-     ForceAssertGt(chunk_size, 0);
 
      if ( !IsDirectory( base_dir ) ) {
           FatalErr(base_dir + " is not a valid directory");
      }
-     // Split into chunks 
+
+     // Count (edge, read id) pairs per edge
      //
      if (verbose)
-          cout << Date( ) << ": writing chunks to disk" << endl;
-     vec<BinaryWriter *> out_chunks;
-     vec<String> part_fn;
-     for ( int i = 0; i != chunks; i++ ) {
-          String fn = base_dir + "/tmp.part."+ToString(i);
-          part_fn.push_back(fn);
-          BinaryWriter * writer = new BinaryWriter(fn);
-          out_chunks.push_back( writer );
-     }
-     
-     for ( uint64_t id = 0; id < uint64_t(paths.size()); id++ ) {
-          const ReadPath & p = paths[id];
+          cout << Date( ) << ": counting edge support" << endl;
+     vec<uint64_t> pos( num_edges, 0 );
+     forEach( [&]( int64_t, ReadPath const& p ) {
           for ( auto e : p ) {
-               const int chunk = e / chunk_size;
-               out_chunks[chunk]->write( make_pair(e, id) );
+               #pragma omp atomic
+               pos[e]++;
           }
-     }
-
-     for ( auto * fptr : out_chunks ) {
-          fptr->close();
-          delete fptr;
-     }
-     if (verbose)
-          cout << Date( ) << ": processing " << chunks << " chunks" << endl;
-     
-     // Process each chunk separately
-     // Do not parallelize because then all of paths_index will
-     // end up in memory
+     } );
+     vec<uint64_t> off( num_edges+1 );
+     off[0] = 0;
+     for ( int e = 0; e < num_edges; e++ )
+          off[e+1] = off[e] + pos[e];
+     const uint64_t total = off[num_edges];
 
-     // Which read ids are un-mapped to the graph?
-     vec<bool> empty (num_edges, true);
-     int numdots=0, done=0;
      // counts vector
      const int ns = 1;
-     vec<vec<int>> countsb( ns, vec<int>(num_edges, -1) );
-     IncrementalWriter<ULongVec> piw ( base_dir + "/" + pi_file );
-     for ( int i = 0; i < chunks; i++ ) {
-          vec<pair<int, unsigned long>> eid;
-          uint64_t size = FileSize( part_fn[i] )/sizeof(pair<int, unsigned long>);
-          eid.resize( size );
-          BinaryReader reader (part_fn[i]);
-          int64_t pos=0;
-          while ( ! reader.atEOF() ) {
-               pair<int, unsigned long> p;
-               reader.read( &p );
-               eid[pos] = p;
-               pos++;
+     vec<vec<int>> countsb( ns, vec<int>(num_edges) );
+     for ( int e = 0; e < num_edges; e++ ) {
+          ForceAssertLe( pos[e], uint64_t(std::numeric_limits<int>::max()) );
+          countsb[0][e] = pos[e];
+     }
+
+     FeudalFileWriter piw( (base_dir + "/" + pi_file).c_str( ),
+               sizeof(ULongVec), sizeof(ULongVec::value_type),
+               ULongVec::fixedDataLen( ), num_edges );
+     const size_t budget = MemAvailable( 0.9 );
+     const size_t need = total * sizeof(unsigned long);
+     if ( need <= budget ) {
+          if (verbose)
+               cout << Date( ) << ": inverting " << total << " pairs in memory" << endl;
+          vec<unsigned long> ids( total );
+          for ( int e = 0; e < num_edges; e++ )
+               pos[e] = off[e];
+          forEach( [&]( int64_t id, ReadPath const& p ) {
+               for ( auto e : p ) {
+                    uint64_t slot;
+                    #pragma omp atomic capture
+                    slot = pos[e]++;
+                    ids[slot] = id;
+               }
+          } );
+          sortEdgeRange( ids, off, 0, num_edges );
+          writeEdgeRange( piw, ids, off, 0, num_edges );
+     } else {
+          // Each partition holds its pairs and then its inverted read ids.
+          const int parts = Max( chunks, int( Min( int64_t(MAX_PARTS),
+               int64_t( (need + sizeof(EdgeRead)*total) / Max(budget, size_t(1)) ) + 1 ) ) );
+          const uint64_t part_size = Max( total / parts, uint64_t(1) );
+          vec<int> ebounds( 1, 0 );
+          for ( int e = 1; e < num_edges; e++ ) {
+               if ( off[e] - off[ ebounds.back( ) ] >= part_size )
+                    ebounds.push_back( e );
           }
-          // Sort eid to put paths_index entries in consecutive order
-          ParallelSort(eid);
-          for ( auto & p : eid ) {
-               if ( empty[ p.first ] )
-                    empty[ p.first ] = false;
+          ebounds.push_back( num_edges );
+          const int nparts = ebounds.isize( ) - 1;
+          if (verbose)
+               cout << Date( ) << ": spilling " << total << " pairs to "
+                    << nparts << " partitions" << endl;
+
+          vec<String> part_fn;
+          vec<BinaryWriter *> out_parts;
+          std::unique_ptr<SpinLockedData[]> locks( new SpinLockedData[nparts] );
+          for ( int i = 0; i < nparts; i++ ) {
+               part_fn.push_back( base_dir + "/tmp.part." + ToString(i) );
+               out_parts.push_back( new BinaryWriter( part_fn.back( ) ) );
           }
+          auto flush = [&]( int i, vec<EdgeRead> & buf ) {
+               SpinLocker lock( locks[i] );
+               out_parts[i]->write( buf.data( ), buf.data( ) + buf.size( ) );
+               buf.clear( );
+          };
+          vec<vec<vec<EdgeRead>>> bufs( omp_get_max_threads( ),
+                    vec<vec<EdgeRead>>(nparts) );
+          forEach( [&]( int64_t id, ReadPath const& p ) {
+               vec<vec<EdgeRead>> & tbufs = bufs[ omp_get_thread_num( ) ];
+               for ( auto e : p ) {
+                    const int i = std::upper_bound( ebounds.begin( ),
+                              ebounds.end( ), e ) - ebounds.begin( ) - 1;
+                    tbufs[i].push_back( make_pair( e, (unsigned long)id ) );
+                    if ( tbufs[i].size( ) == SPILL_BUFFER )
+                         flush( i, tbufs[i] );
+               }
+          } );
+          for ( auto & tbufs : bufs )
+               for ( int i = 0; i < nparts; i++ )
+                    flush( i, tbufs[i] );
+          Destroy(bufs);
+          for ( auto * fptr : out_parts ) {
+               fptr->close();
+               delete fptr;
+          }
+
+          // Invert each partition in memory, in edge order.
+          int numdots=0, done=0;
+          for ( int i = 0; i < nparts; i++ ) {
+               const int eb = ebounds[i], ee = ebounds[i+1];
+               const uint64_t base = off[eb];
+               vec<EdgeRead> eid( off[ee] - base );
+               BinaryReader reader( part_fn[i] );
+               reader.read( eid.data( ), eid.data( ) + eid.size( ) );
+               ForceAssert( reader.atEOF( ) );
+               SystemSucceed( "rm " + part_fn[i] );
 
-          unsigned long j = 0;
-          // Write read ids ONLY into paths_index part file
-          const int emax = Min( (i+1)*chunk_size, num_edges );
-          for ( int e = i*(chunk_size); e < emax; e++ ) {
-               ULongVec entry;
-               if ( empty[e] )
-                    piw.add( entry );
-               else {
-                    while( j < eid.size() && eid[j].first == e ) {
-                         entry.push_back( eid[j].second );
-                         j++;
-                    }
-                    piw.add( entry );
+               vec<unsigned long> ids( eid.size( ) );
+               vec<uint64_t> loff( ee - eb + 1 );
+               for ( int e = eb; e <= ee; e++ )
+                    loff[e-eb] = off[e] - base;
+               for ( int e = eb; e < ee; e++ )
+                    pos[e] = loff[e-eb];
+               #pragma omp parallel for
+               for ( uint64_t j = 0; j < eid.size( ); j++ ) {
+                    uint64_t slot;
+                    #pragma omp atomic capture
+                    slot = pos[ eid[j].first ]++;
+                    ids[slot] = eid[j].second;
                }
-               countsb[0][e] = entry.size();
+               Destroy(eid);
+               // loff is indexed by e-eb
+               sortEdgeRange( ids, loff, 0, ee - eb );
+               writeEdgeRange( piw, ids, loff, 0, ee - eb );
+               if (verbose)
+                    MakeDots( done, numdots, nparts );
           }
-          if (verbose)
-               MakeDots( done, numdots, chunks );
      }
      piw.close();
-     // check that all countsb elements are initialized
-     for ( int n = 0; n < ns; n++ ) {
-          for ( auto c : countsb[n] )
-               ForceAssertGe ( c, 0 );
-     }
-     
+     Destroy(pos);
+     Destroy(off);
+
      // add in the inverse edges
      #pragma omp parallel for collapse(2)
      for ( int n = 0; n < ns; n++ ) {
@@ -133,15 +241,19 @@ void writePathsIndex( ReadPathVec & paths, vec<int> & inv,
      }
      // write countsb
      BinaryWriter::writeFile( base_dir + "/" + counts_file, countsb );
+}
 
-     // Delete all the initially created tmp files
-     if (verbose)
-          cout << Date( ) <<": deleting tmp files" << endl;
-     for ( auto fn : part_fn )
-          SystemSucceed( "rm " + fn );
+}
 
+void writePathsIndex( ReadPathVec & paths, vec<int> & inv,
+                      String base_dir, String pi_file = "a.paths.inv",
+                      String counts_file = "a.countsb",
+                      const int chunks = 15, bool verbose=false )
+{
+     cout << Date( ) << ": inverting paths" << endl;
+     invertPaths( ForEachPath{paths}, inv, base_dir, pi_file, counts_file,
+                  chunks, verbose );
      cout << Date( ) << ": done" << endl;
-     
 }
 
 void writePathsIndex( ReadPathVecX & paths, const HyperBasevectorX& hb, vec<int> & inv,
@@ -150,148 +262,16 @@ void writePathsIndex( ReadPathVecX & paths, const HyperBasevectorX& hb, vec<int>
                       const int chunks = 15, bool verbose=false )
 {
      cout << Date( ) << ": inverting pathsX" << endl;
-     const int num_edges = inv.size();
-     ForceAssertGt( num_edges, 0 );
-     ForceAssertGt( chunks, 0 );
-     const int chunk_size = num_edges/chunks + 1;
-     ForceAssertGt(chunk_size, 0);
-
-     if ( !IsDirectory( base_dir ) ) {
-          FatalErr(base_dir + " is not a valid directory");
-     }
-     // Split into chunks 
-     //
-     if (verbose)
-          cout << Date( ) << ": writing chunks to disk" << endl;
-     vec<BinaryWriter *> out_chunks;
-     vec<String> part_fn;
-     for ( int i = 0; i != chunks; i++ ) {
-          String fn = base_dir + "/tmp.part."+ToString(i);
-          part_fn.push_back(fn);
-          BinaryWriter * writer = new BinaryWriter(fn);
-          out_chunks.push_back( writer );
-     }
-     const int pbatch = omp_get_max_threads()*1000;
-     int pbatches = paths.size()/pbatch + 1;
-     int numdots = 0, done=0;
-     ReadPathVec bpaths;
-     for ( uint64_t start = 0; start < (uint64_t) (paths.size()); start+=pbatch ) {
-          const uint64_t stop = Min( uint64_t(paths.size()), start+pbatch );
-          bpaths.resize(stop-start);
-          if (start == 0) {
-               for ( auto & p : bpaths )
-                    p.reserve(2);
-          }
-          #pragma omp parallel for
-          for ( uint64_t id = start; id < stop; id++ ) {
-               ReadPath & p = bpaths[id-start];
-               paths.unzip(p,hb,id);
-          }
-          for ( uint64_t id = start; id < stop; id++ ) {
-               for ( auto & e: bpaths[id-start] ) {
-                    const int chunk = e / chunk_size;
-                    { out_chunks[chunk]->write( make_pair(e, id) ); }
-               }
-          }
-          if (verbose ) {
-               MakeDots( done, numdots, pbatches );
-          }
-     }
-     Destroy(bpaths);
-
-     for ( auto * fptr : out_chunks ) {
-          fptr->close();
-          delete fptr;
-     }
-     if (verbose)
-          cout << Date( ) << ": processing " << chunks << " chunks" << endl;
-     
-     // Process each chunk separately
-     // Do not parallelize because then all of paths_index will
-     // end up in memory
-
-     // Which read ids are un-mapped to the graph?
-     vec<bool> empty (num_edges, true);
-     // counts vector
-     const int ns = 1;
-     vec<vec<int>> countsb( ns, vec<int>(num_edges, -1) );
-     numdots=0;
-     done=0;
-     IncrementalWriter<ULongVec> piw ( base_dir + "/" + pi_file );
-     for ( int i = 0; i < chunks; i++ ) {
-          vec<pair<int, unsigned long>> eid;
-          uint64_t size = FileSize( part_fn[i] )/sizeof(pair<int, unsigned long>);
-          eid.resize( size );
-          BinaryReader reader (part_fn[i]);
-          int64_t pos=0;
-          while ( ! reader.atEOF() ) {
-               pair<int, unsigned long> p;
-               reader.read( &p );
-               eid[pos] = p;
-               pos++;
-          }
-          // Sort eid to put paths_index entries in consecutive order
-          ParallelSort(eid);
-          for ( auto & p : eid ) {
-               if ( empty[ p.first ] )
-                    empty[ p.first ] = false;
-          }
-
-          unsigned long j = 0;
-          // Write read ids ONLY into paths_index part file
-          const int emax = Min( (i+1)*chunk_size, num_edges );
-          for ( int e = i*(chunk_size); e < emax; e++ ) {
-               ULongVec entry;
-               if ( empty[e] )
-                    piw.add( entry );
-               else {
-                    while( j < eid.size() && eid[j].first == e ) {
-                         entry.push_back( eid[j].second );
-                         j++;
-                    }
-                    piw.add( entry );
-               }
-               countsb[0][e] = entry.size();
-          }
-          if (verbose)
-               MakeDots( done, numdots, chunks );
-     }
-     piw.close();
-     
-     // check that all countsb elements are initialized
-     for ( int n = 0; n < ns; n++ ) {
-          for ( auto c : countsb[n] )
-               ForceAssertGe ( c, 0 );
-     }
-     
-     // add in the inverse edges
-     #pragma omp parallel for collapse(2)
-     for ( int n = 0; n < ns; n++ ) {
-          for ( int e = 0; e < num_edges; e++ ) {
-               const int re = inv[e];
-               if ( e < re ) {
-                    const int tot = countsb[n][e] + countsb[n][re];
-                    countsb[n][e]  = tot;
-                    countsb[n][re] = tot;
-               }
-          }
-     }
-     // write countsb
-     BinaryWriter::writeFile( base_dir + "/" + counts_file, countsb );
-
-     // Delete all the initially created tmp files
-     if (verbose)
-          cout << Date( ) <<": deleting tmp files" << endl;
-     for ( auto fn : part_fn )
-          SystemSucceed( "rm " + fn );
-     
+     invertPaths( ForEachPathX{paths, hb}, inv, base_dir, pi_file, counts_file,
+                  chunks, verbose );
      cout << Date( ) << ": done" << endl;
-     
 }
 
 
 /* Compute the base edge --> barcode vector map
- * Stored as VecIntVec ebcx
+ * Stored as VecIntVec ebcx, each list sorted without duplicates, so that
+ * SortedMeetSize and SortedIntersection apply.  The lists are not compressed:
+ * callers index them directly and a.ebcx is read back as a VecIntVec.
  */
 
 void computeEdgeToBarcodeX( const ReadPathVecX & paths, const HyperBasevectorX& hb, 
@@ -325,8 +305,10 @@ void computeEdgeToBarcodeX( const ReadPathVecX & paths, const HyperBasevectorX&
           cout << Date( ) << ": computed bce" << endl;
      // Count edges
      vec <int> num_bc (num_edges, 0);
+     #pragma omp parallel for schedule(dynamic, 1000)
      for ( int bi = 0; bi < num_batches; bi++ ) {
           for ( auto e : bce[bi] ) {
+               #pragma omp atomic
                num_bc[e]++;
           }
      }
@@ -340,19 +322,24 @@ void computeEdgeToBarcodeX( const ReadPathVecX & paths, const HyperBasevectorX&
      
      if (verbose)
           cout << Date( ) << ": filling up ebcx" << endl;
-     // Construct the index
+     // Construct the index.  Batches are scattered in parallel, so each
+     // edge's barcodes are then sorted to put them back in batch order.
+     #pragma omp parallel for schedule(dynamic, 1000)
      for ( int bi = 0; bi < num_batches; bi++ ) {
           const int32_t b = bc[bci[bi]];
           if (b > 0) {
-               vec<int> & edges = bce[bi];
-               #pragma omp parallel for
-               for ( int ei = 0; ei < edges.isize(); ei++ ) {
-                    const int e = edges[ei];
-                    ebcx[e][pos[e]] = b ;
-                    pos[e]++;
+               for ( auto e : bce[bi] ) {
+                    int p;
+                    #pragma omp atomic capture
+                    p = pos[e]++;
+                    ebcx[e][p] = b;
                }
+               Destroy( bce[bi] );
           }
      }
+     #pragma omp parallel for schedule(dynamic, 1000)
+     for ( int e = 0; e < num_edges; e++ )
+          std::sort( ebcx[e].begin( ), ebcx[e].end( ) );
      if (verbose)
           cout << Date( ) << ": done" << endl;
 }
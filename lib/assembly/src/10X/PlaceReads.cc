@@ -1151,26 +1151,19 @@ void PlaceReads( const HyperBasevectorX& hb, const ReadPathVecX& paths,
      D.ToLeft(to_left), D.ToRight(to_right);
      if (verbose) cout << Date( ) << ": looking at reads" << endl;
      double clock = WallClockTime( );
-     const int batch = 100000;
-     int nthreads = ( single ? 1 : omp_get_max_threads( ) );
-     #pragma omp parallel for num_threads(nthreads) schedule(dynamic,1)
-     for ( int64_t bi = 0; bi < (int64_t) paths.size( ); bi += batch )
-     {    vec<int> aplace, d, x;
-          ReadPath p;
-          for ( int64_t id = bi; 
-               id < Min( bi + batch, (int64_t) paths.size( ) ); id++ )
+     vec<int> aplace, d, x;
+     paths.forEachPath( hb, 0, paths.size( ),
+          [&,aplace,d,x]( int64_t id, const ReadPath& p ) mutable
           {    dpaths[id].resize(0); 
-               if ( dup[id/2] ) continue;
-               p.clear( );
-               paths.unzip(p,hb,id);
+               if ( dup[id/2] ) return;
                int nplaces, pos;
                if ( !FindPlaces( p, d, x, hb, D, dlens, to_left, to_right, 
                     nd, align2, nplaces, pos, aplace ) )
-               {    continue;    }
+               {    return;    }
                dpaths[id].resize( aplace.size( ) );
                for ( int j = 0; j < aplace.isize( ); j++ )
                     dpaths[id][j] = aplace[j];
-               dpaths[id].setOffset(pos);    }     }
+               dpaths[id].setOffset(pos);    }, !single );
      if (verbose) cout << Date( ) << ": done, used " << TimeSince(clock) << endl;
      int64_t placed = 0;
      for ( int64_t id = 0; id < (int64_t) paths.size( ); id++ )
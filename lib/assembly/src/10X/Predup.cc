@@ -7,65 +7,169 @@
 
 #include "Basevector.h"
 #include "CoreTools.h"
-#include "VecUtilities.h"
+#include "feudal/BinaryStream.h"
+#include "feudal/IncrementalWriter.h"
 #include "feudal/PQVec.h"
-#include "kmers/KmerRecord.h"
 #include "10X/Predup.h"
 
-void Predup( vecbasevector& bases, VecPQVec& quals, vec<int64_t>& bci )
+namespace
 {
-     // First mark dups.
+
+// Two pairs are duplicates if the first HEAD bases of their first reads agree
+// and the first HEAD bases of their second reads agree.
+
+const unsigned HEAD = 40;
+
+// The first HEAD bases of a read, two bits per base, tagged with the number of
+// bases, so that short reads only match reads of the same length.
+
+struct ReadHead
+{    uint64_t lo, hi;
+
+     friend bool operator==( ReadHead const& h1, ReadHead const& h2 )
+     {    return h1.lo == h2.lo && h1.hi == h2.hi;    }    };
+
+ReadHead GetHead( basevector const& b )
+{    ReadHead h{ 0, 0 };
+     unsigned len = Min( (unsigned) b.size( ), HEAD );
+     for ( unsigned pos = 0; pos < len; pos += 16 )
+     {    uint64_t w = b.extractKmer( pos, Min( 16u, len - pos ) );
+          if ( pos < 32 ) h.lo |= w << ( 2 * pos );
+          else h.hi |= w << ( 2 * ( pos - 32 ) );    }
+     h.hi |= uint64_t(len) << 32;
+     return h;    }
+
+// The splitmix64 finalizer.
+
+inline uint64_t Mix( uint64_t x )
+{    x ^= x >> 30;
+     x *= 0xbf58476d1ce4e5b9ul;
+     x ^= x >> 27;
+     x *= 0x94d049bb133111ebul;
+     return x ^ ( x >> 31 );    }
+
+// A 128-bit hash of the heads of the two reads of a pair.
+
+struct PairSig
+{    uint64_t s1, s2;
+
+     PairSig( ReadHead const& h1, ReadHead const& h2 )
+          : s1( Mix( h1.lo ^ Mix( h1.hi ) ) ), s2( Mix( h2.lo ^ Mix( h2.hi ) ) ) { }
+
+     friend bool operator==( PairSig const& p1, PairSig const& p2 )
+     {    return p1.s1 == p2.s1 && p1.s2 == p2.s2;    }    };
+
+// Open-addressed hash table holding, for each distinct pair signature in a
+// barcode, the best pair seen so far.  Each thread keeps one and reuses it for
+// all its barcodes: a slot is live only if it carries the current generation,
+// so starting a new barcode doesn't require clearing the table.
+
+class PairTable
+{
+public:
+     struct Slot
+     {    PairSig sig;
+          int64_t pid;
+          int64_t qsum; // -1 until needed
+          uint32_t gen;
+
+          Slot( ) : sig( ReadHead{0,0}, ReadHead{0,0} ), pid(-1), qsum(-1), gen(0) { }    };
+
+     // Start over, for a barcode having npairs pairs.
+
+     void Reset( int64_t npairs )
+     {    size_t need = 16;
+          while ( need < 2 * (size_t) npairs ) need <<= 1;
+          if ( need > slots_.size( ) || ++gen_ == 0 )
+          {    slots_.assign( Max( need, slots_.size( ) ), Slot( ) );
+               gen_ = 1;    }
+          mask_ = need - 1;    }
+
+     // Return the live slot for a pair having signature sig, or the free slot
+     // where it belongs.  Slots with a matching signature are only accepted
+     // if same(pid) confirms the match, so hash collisions do no harm.
+
+     template <class Same> Slot& Find( PairSig const& sig, Same const& same )
+     {    for ( size_t i = sig.s1 & mask_; ; i = ( i + 1 ) & mask_ )
+          {    Slot& s = slots_[i];
+               if ( s.gen != gen_ ) return s;
+               if ( s.sig == sig && same( s.pid ) ) return s;    }    }
+
+     bool Live( Slot const& s ) const { return s.gen == gen_; }
+
+     void Claim( Slot& s, PairSig const& sig, int64_t pid )
+     {    s.sig = sig, s.pid = pid, s.qsum = -1, s.gen = gen_;    }
+
+private:
+     vec<Slot> slots_;
+     size_t mask_ = 0;
+     uint32_t gen_ = 0;
+};
+
+}
+
+void Predup( vecbasevector& bases, VecPQVec& quals, vec<int64_t>& bci,
+     String const& out_head )
+{
+     // First mark dups.  Quality sums are only computed for pairs that have
+     // a duplicate, straight from the packed quals.  Among duplicates, the pair
+     // with the highest quality sum survives, the earliest one in case of ties.
 
      cout << Date( ) << ": start predup" << endl;
      vec<int64_t> sizes( bci.isize( ) - 1 );
      sizes[0] = bci[1];
      vec<Bool> to_delete( bases.size( ), False );
+     auto QualSum = [&quals]( int64_t pid )
+     {    return int64_t( quals[2*pid].qualSum( ) + quals[2*pid+1].qualSum( ) );    };
      cout << Date( ) << ": marking duplicates" << endl;
-     #pragma omp parallel for
-     for ( int bi = 1; bi < bci.isize( ) - 1; bi++ )
-     {    int64_t start = bci[bi], stop = bci[bi+1];
-
-          // Form first 40 bases of first read + first 40 bases of second read.
-          // If another pair has the same value, declare them duplicates of each
-          // other.
-
-          const int K = 40;
-          vec< triple< kmer<K>, kmer<K>, int64_t > > sig( (stop-start)/2 );
-          for ( int64_t pid = start/2; pid < stop/2; pid++ )
-          {    sig[pid - start/2].first.SetToSubOf( bases[2*pid], 0 );
-               sig[pid - start/2].second.SetToSubOf( bases[2*pid+1], 0 );
-               sig[pid - start/2].third = pid;    }
-          Sort(sig);
-          vec<int> qsum;
-          qualvector q;
-          for ( int64_t j = 0; j < sig.jsize( ); j++ )
-          {    int64_t k;
-               for ( k = j + 1; k < sig.jsize( ); k++ )
-               {    if ( sig[k].first != sig[j].first ) break;
-                    if ( sig[k].second != sig[j].second ) break;    }
-               if ( k - j > 1 )
-               {    qsum.resize_and_set( k - j, 0 );
-                    for ( int64_t l = j; l < k; l++ )
-                    {    int64_t pid = sig[l].third;
-                         quals[2*pid].unpack(&q);
-                         for ( int m = 0; m < (int) q.size( ); m++ )
-                              qsum[l-j] += q[m];
-                         quals[2*pid+1].unpack(&q);
-                         for ( int m = 0; m < (int) q.size( ); m++ )
-                              qsum[l-j] += q[m];    }
-                    vec<int> ids( k - j, vec<int>::IDENTITY );
-                    ReverseSortSync( qsum, ids );
-                    for ( int64_t l = j; l < k; l++ )
-                    {    if ( l - j == ids[0] ) continue;
-                         int64_t pid = sig[l].third;
-                         to_delete[ 2*pid ] = True;
-                         to_delete[ 2*pid + 1 ] = True;    }    }
-               sizes[bi] += 2;
-               j = k - 1;    }    }
-
-     // Now delete dups.
+     #pragma omp parallel
+     {    PairTable table;
+          vec<ReadHead> heads;
+          #pragma omp for schedule(dynamic, 64)
+          for ( int bi = 1; bi < bci.isize( ) - 1; bi++ )
+          {    int64_t start = bci[bi]/2, stop = bci[bi+1]/2;
+               heads.resize( 2 * ( stop - start ) );
+               for ( int64_t pid = start; pid < stop; pid++ )
+               {    heads[ 2*(pid-start) ] = GetHead( bases[2*pid] );
+                    heads[ 2*(pid-start) + 1 ] = GetHead( bases[2*pid+1] );    }
+               table.Reset( stop - start );
+               for ( int64_t pid = start; pid < stop; pid++ )
+               {    ReadHead const* h = &heads[ 2*(pid-start) ];
+                    PairSig sig( h[0], h[1] );
+                    auto& slot = table.Find( sig, [&]( int64_t other )
+                    {    ReadHead const* g = &heads[ 2*(other-start) ];
+                         return g[0] == h[0] && g[1] == h[1];    } );
+                    if ( !table.Live(slot) )
+                    {    table.Claim( slot, sig, pid );
+                         sizes[bi] += 2;
+                         continue;    }
+                    if ( slot.qsum < 0 ) slot.qsum = QualSum( slot.pid );
+                    int64_t qsum = QualSum(pid), loser = pid;
+                    if ( qsum > slot.qsum )
+                    {    loser = slot.pid;
+                         slot.pid = pid, slot.qsum = qsum;    }
+                    to_delete[ 2*loser ] = to_delete[ 2*loser + 1 ] = True;    }    }    }
+
+     // Now delete dups, writing out the survivors as we go, if requested.
 
      cout << Date( ) << ": deleting dups" << endl;
-     bases.EraseIf(to_delete), quals.EraseIf(to_delete);
      for ( int bi = 1; bi < bci.isize( ) - 1; bi++ )
-          bci[bi+1] = bci[bi] + sizes[bi];    }
+          bci[bi+1] = bci[bi] + sizes[bi];
+     if ( out_head == "" )
+     {    bases.EraseIf(to_delete), quals.EraseIf(to_delete);
+          return;    }
+     cout << Date( ) << ": writing " << out_head << ".{fastb,qualp,bci}" << endl;
+     IncrementalWriter<basevector> bases_out( out_head + ".fastb" );
+     IncrementalWriter<PQVec> quals_out( out_head + ".qualp" );
+     size_t dest = 0;
+     for ( size_t id = 0; id < bases.size( ); id++ )
+     {    if ( to_delete[id] ) continue;
+          bases_out.add( bases[id] ), quals_out.add( quals[id] );
+          if ( dest != id )
+          {    bases.SwapElements( dest, id );
+               quals.SwapElements( dest, id );    }
+          dest++;    }
+     bases_out.close( ), quals_out.close( );
+     bases.resize(dest), quals.resize(dest);
+     ForceAssertEq( (int64_t) dest, bci.back( ) );
+     BinaryWriter::writeFile( out_head + ".bci", bci );    }
@@ -9,6 +9,11 @@
 #include "CoreTools.h"
 #include "feudal/PQVec.h"
 
-void Predup( vecbasevector& bases, VecPQVec& quals, vec<int64_t>& bci );
+// Remove duplicate pairs within each barcode, keeping the pair with the highest
+// quality sum.  If out_head is nonempty, the surviving reads are also written
+// to out_head.{fastb,qualp,bci} as they're compacted.
+
+void Predup( vecbasevector& bases, VecPQVec& quals, vec<int64_t>& bci,
+     String const& out_head = "" );
 
 #endif
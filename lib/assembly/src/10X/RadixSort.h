@@ -0,0 +1,195 @@
+// Copyright (c) 2016 10X Genomics, Inc. All rights reserved.
+
+// ParallelRadixSort: in-place most-significant-digit radix sort of a vec
+// (American flag sort), eight bits per pass.  The caller describes the key as
+// a sequence of byte digits, digit 0 being the least significant, so that
+// records packing a key of 64 or 128 bits (plus whatever payload rides along)
+// sort mostly without comparisons.  Each pass counts the records of a bucket by
+// digit value and then permutes them into place by swapping, so no scratch
+// copy of the input is made.  A digit that is the same throughout a bucket
+// costs a count but no permutation.  Buckets of fewer than RADIX_SORT_SMALL
+// records, and records equal in every digit, are finished with std::sort using
+// less, which must order records by their digits first.  The sort is not
+// stable; put whatever should break ties (a read id, say) into less.
+//
+// The top-level count runs over contiguous blocks in parallel, the top-level
+// permutation runs in parallel by stripes of the buckets, and the buckets it
+// yields are then sorted in parallel.
+
+#ifndef TENX_RADIX_SORT_H
+#define TENX_RADIX_SORT_H
+
+// MakeDepend: cflags OMP_FLAGS
+
+#include <algorithm>
+#include <functional>
+#include <omp.h>
+
+#include "CoreTools.h"
+
+const int64_t RADIX_SORT_SMALL = 64;
+
+// Move records into place by swapping, given that bucket x holds only records
+// of digit d equal to x before head[x], and that the records in the ranges
+// [head[x],end[x]) are exactly the ones that belong in them, in some order.
+
+template<class T, class DigitFn>
+void RadixSortPlace( T* v, const int d, DigitFn& digit, int64_t* head,
+     const int64_t* end )
+{    for ( int x = 0; x < 256; x++ )
+     {    while ( head[x] < end[x] )
+          {    const int y = digit( v[ head[x] ], d );
+               if ( y == x ) head[x]++;
+               else std::swap( v[ head[x] ], v[ head[y]++ ] );    }    }    }
+
+// Permute v[0,n) into buckets by the given counts of digit d.  On return,
+// start[x] is the first record of bucket x.
+
+template<class T, class DigitFn>
+void RadixSortPermute( T* v, const int d, DigitFn& digit, const int64_t* count,
+     int64_t* start )
+{    int64_t head[256], end[256];
+     int64_t sum = 0;
+     for ( int x = 0; x < 256; x++ )
+     {    start[x] = head[x] = sum;
+          sum += count[x];
+          end[x] = sum;    }
+     RadixSortPlace( v, d, digit, head, end );    }
+
+// As RadixSortPermute, using nb threads.  Each round cuts what is left of every
+// bucket into nb stripes, and thread b places records by swapping them within
+// its own stripes only, setting aside those whose stripe is already full.  Then,
+// in parallel by bucket, the records set aside are swapped to the end of their
+// bucket, leaving the rest of the bucket done.  Rounds repeat while they place
+// at least half of what is left, and RadixSortPlace finishes the job.
+
+template<class T, class DigitFn>
+void RadixSortPermuteParallel( T* v, const int d, DigitFn& digit,
+     const int64_t* count, int64_t* start, const int nb )
+{    int64_t head[256], end[256];
+     int64_t sum = 0;
+     for ( int x = 0; x < 256; x++ )
+     {    start[x] = head[x] = sum;
+          sum += count[x];
+          end[x] = sum;    }
+     vec<int64_t> shead( nb * 256 ), send( nb * 256 );
+     int64_t left = sum;
+     while ( nb > 1 && left >= 65536 )
+     {    for ( int b = 0; b < nb; b++ )
+          {    for ( int x = 0; x < 256; x++ )
+               {    const int64_t len = end[x] - head[x];
+                    shead[ b * 256 + x ] = head[x] + len * b / nb;
+                    send[ b * 256 + x ] = head[x] + len * (b+1) / nb;    }    }
+
+          // In stripe x of thread b, records before h[x] are placed.  While
+          // stripe x is being worked on, the records from h[x] up to i have
+          // been set aside.
+
+          #pragma omp parallel for num_threads(nb)
+          for ( int b = 0; b < nb; b++ )
+          {    int64_t* h = &shead[ b * 256 ];
+               const int64_t* e = &send[ b * 256 ];
+               for ( int x = 0; x < 256; x++ )
+               {    for ( int64_t i = h[x]; i < e[x]; i++ )
+                    {    int y = digit( v[i], d );
+                         while ( y != x && h[y] < e[y] )
+                         {    std::swap( v[i], v[ h[y]++ ] );
+                              y = digit( v[i], d );    }
+                         if ( y == x ) std::swap( v[i], v[ h[x]++ ] );    }    }    }
+
+          // Swap the records set aside in bucket x with placed records from
+          // the end of it.  Records of other digits are exactly the ones set
+          // aside.
+
+          #pragma omp parallel for schedule(dynamic,1)
+          for ( int x = 0; x < 256; x++ )
+          {    int64_t aside = 0;
+               for ( int b = 0; b < nb; b++ )
+                    aside += send[ b * 256 + x ] - shead[ b * 256 + x ];
+               const int64_t done = end[x] - aside;
+               int64_t j = done;
+               for ( int b = 0; b < nb; b++ )
+               {    const int64_t stop = Min( send[ b * 256 + x ], done );
+                    for ( int64_t i = shead[ b * 256 + x ]; i < stop; i++ )
+                    {    while ( digit( v[j], d ) != x ) j++;
+                         std::swap( v[i], v[j++] );    }    }
+               head[x] = done;    }
+
+          int64_t now_left = 0;
+          for ( int x = 0; x < 256; x++ )
+               now_left += end[x] - head[x];
+          const Bool progress = ( 2 * now_left <= left );
+          left = now_left;
+          if ( !progress ) break;    }
+     RadixSortPlace( v, d, digit, head, end );    }
+
+// Sort v[0,n) on digits d, ..., 0, serially.
+
+template<class T, class DigitFn, class Less>
+void RadixSortBucket( T* v, const int64_t n, int d, DigitFn& digit, Less& less )
+{    for ( ; d >= 0 && n >= RADIX_SORT_SMALL; d-- )
+     {    int64_t count[256] = { 0 };
+          for ( int64_t i = 0; i < n; i++ )
+               count[ digit( v[i], d ) ]++;
+          if ( count[ digit( v[0], d ) ] == n ) continue;
+          int64_t start[256];
+          RadixSortPermute( v, d, digit, count, start );
+          for ( int x = 0; x < 256; x++ )
+          {    if ( count[x] > 1 )
+                    RadixSortBucket( v + start[x], count[x], d-1, digit, less );    }
+          return;    }
+     if ( n > 1 ) std::sort( v, v + n, less );    }
+
+template<class T, class DigitFn, class Less>
+void ParallelRadixSort( vec<T>& v, const int ndigits, DigitFn digit, Less less )
+{    const int64_t N = v.size( );
+     if ( N < RADIX_SORT_SMALL )
+     {    std::sort( v.begin( ), v.end( ), less );
+          return;    }
+     const int nb = Max( (int64_t) 1,
+          Min( (int64_t) omp_get_max_threads( ), N / 65536 ) );
+     auto bstart = [&]( const int b ) { return N * b / nb; };
+
+     // Find the most significant digit that varies, and count by it.
+
+     vec<int64_t> bcount( nb * 256 );
+     int64_t count[256];
+     int d;
+     for ( d = ndigits - 1; d >= 0; d-- )
+     {
+          #pragma omp parallel for num_threads(nb)
+          for ( int b = 0; b < nb; b++ )
+          {    int64_t* c = &bcount[ b * 256 ];
+               std::fill( c, c + 256, 0 );
+               for ( int64_t i = bstart(b); i < bstart(b+1); i++ )
+                    c[ digit( v[i], d ) ]++;    }
+          for ( int x = 0; x < 256; x++ )
+          {    count[x] = 0;
+               for ( int b = 0; b < nb; b++ )
+                    count[x] += bcount[ b * 256 + x ];    }
+          if ( count[ digit( v[0], d ) ] < N ) break;    }
+     if ( d < 0 )
+     {    std::sort( v.begin( ), v.end( ), less );
+          return;    }
+
+     // Permute by that digit, then sort the buckets in parallel, largest first.
+
+     int64_t start[256];
+     RadixSortPermuteParallel( v.data( ), d, digit, count, start, nb );
+     vec<int> order;
+     for ( int x = 0; x < 256; x++ )
+          if ( count[x] > 1 ) order.push_back(x);
+     std::sort( order.begin( ), order.end( ),
+          [&]( const int x, const int y ) { return count[x] > count[y]; } );
+     #pragma omp parallel for schedule(dynamic,1)
+     for ( int j = 0; j < order.isize( ); j++ )
+     {    const int x = order[j];
+          RadixSortBucket( v.data( ) + start[x], count[x], d-1, digit, less );    }    }
+
+// Sort packed 64-bit keys.
+
+inline void ParallelRadixSort( vec<uint64_t>& v )
+{    ParallelRadixSort( v, 8, []( const uint64_t x, const int d )
+          { return int( ( x >> ( 8 * d ) ) & 255 ); }, std::less<uint64_t>( ) );    }
+
+#endif
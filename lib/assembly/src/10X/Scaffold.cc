@@ -16,6 +16,7 @@
 #include "10X/Heuristics.h"
 #include "10X/IntIndex.h"
 #include "10X/Scaffold.h"
+#include "10X/SortedIntSets.h"
 #include "10X/Super.h"
 #include "10X/LineOO.h"
 #include "10X/MakeLocalsTools.h"
@@ -359,7 +360,7 @@ void Scaffold( const HyperBasevectorX& hb, const vec<int>& inv,
                // Require barcode linking if there's an opportunity.
 
                if ( right_enuf[l1] && left_enuf[l2]
-                    && MeetSize( right_bc[l1], left_bc[l2] ) < MIN_BC )
+                    && SortedMeetSize( right_bc[l1], left_bc[l2] ) < MIN_BC )
                {    continue;    }
 
                // Record link.
@@ -739,7 +740,7 @@ void ScaffoldLowMem( const HyperBasevectorX& hb, const vec<int>& inv,
                // Require barcode linking if there's an opportunity.
 
                if ( right_enuf[l1] && left_enuf[l2]
-                    && MeetSize( right_bc[l1], left_bc[l2] ) < MIN_BC )
+                    && SortedMeetSize( right_bc[l1], left_bc[l2] ) < MIN_BC )
                {    continue;    }
 
                // Record link.
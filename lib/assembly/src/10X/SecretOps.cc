@@ -14,7 +14,9 @@
 #include "random/Random.h"
 #include "10X/Closer.h"
 #include "10X/Heuristics.h"
+#include "10X/RadixSort.h"
 #include "10X/SecretOps.h"
+#include "10X/SortedIntSets.h"
 #include "system/SortInPlace.h"
 #include "10X/DfTools.h"
 #include "10X/paths/ReadPathVecX.h"
@@ -409,197 +411,206 @@ template void IntSpaceExts( const int e, const HyperBasevectorX& hb,
 // score identical to another read.  If present in large numbers, they would
 // presumably have to arise from an informatic mixup.
 
-template< class VB, class VQ, class VP >
-void MarkDups( VB& bases, VQ& quals, VP& paths, const vec<int32_t>& bc,
-     vec<Bool>& dup, double& interdup_rate, const Bool verbose )
-{    
-     cout << Date( ) << ": MarkDups, version 1" << endl;
+namespace {
 
-     // Heuristics.
+// A read placement, packed for duplicate finding: first edge and offset in hi,
+// head of the partner read and read id in lo.  Placements that agree in all but
+// the id are duplicates of each other.
 
-     const int BHEAD = 5;
-
-     // Start.
+struct DupKey {
+     uint64_t hi, lo;
+     Bool SameGroup( const DupKey& x ) const
+     {    return hi == x.hi && ( lo >> 48 ) == ( x.lo >> 48 );    }
+     int64_t Id( ) const { return lo & ( ( uint64_t(1) << 48 ) - 1 ); }
+};
 
-     double clock = WallClockTime( );
-     dup.resize_and_set( bases.size( ) / 2, False );
+const uint64_t DUP_KEY_NONE = ~uint64_t(0);
 
-     // Prepare data structure that will allow duplicate identification.
+inline DupKey MakeDupKey(
+     const int e, const int offset, const int head, const int64_t id )
+{    DupKey x;
+     x.hi = ( uint64_t( uint32_t(e) ) << 32 ) | ( uint32_t(offset) ^ 0x80000000u );
+     x.lo = ( uint64_t(head) << 48 ) | uint64_t(id);
+     return x;    }
 
-     vec< quad<int,int,int,int64_t> > X( bases.size( ) ); // (e,offset,head2,id1)
-     cout << Date( ) << ": making X" << endl;
-     #pragma omp parallel for
-     for ( int64_t id1 = 0; id1 < (int64_t) bases.size( ); id1++ )
-     {    int64_t id2 = ( id1 % 2 == 0 ? id1 + 1 : id1 - 1 );
-          const ReadPath& p = paths[id1];
-          if ( p.size( ) == 0 ) X[id1] = make_quad( -1, -1, -1, -1 );
-          else
-          {    int n = 0;
-               for ( int j = 0; j < BHEAD; j++ )
-               {    n *= 4;
-                    n += bases[id2][j];    }
-               X[id1] = make_quad( p[0], p.getOffset( ), n, id1 );    }    }
+// Given X, one DupKey per read (DUP_KEY_NONE for unplaced reads), in id order,
+// find the duplicate groups and mark all but the best pair of each.
 
-     // Sort, then mark dups.
+template< class VB, class VQ >
+void MarkDupsCore( VB& bases, VQ& quals, vec<DupKey>& X, const vec<int32_t>& bc,
+     vec<Bool>& dup, double& interdup_rate, const Bool verbose, const double clock )
+{
+     // Drop unplaced reads, then sort.  The radix digits are the key above the
+     // read id; ties are broken on the whole of lo, so within a group ids are
+     // ascending.  The sort is in place, so X is the only copy of the keys.
 
-     cout << Date( ) << ": sorting" << endl;
-//     ParallelSort(X);
-     sortInPlaceParallel( X.begin(), X.end() );
-     cout << Date( ) << ": marking dups" << endl;
-//     vec<Bool> dup1( X.size( ), False );
-     std::set< int64_t > dup1;
-     int64_t ndups = 0, interdups = 0;
+     ForceAssertLt( (int64_t) bases.size( ), int64_t(1) << 48 );
+     int64_t nplaced = 0;
      for ( int64_t j = 0; j < X.jsize( ); j++ )
-     {    if ( X[j].first < 0 ) continue;
-          int64_t k;
-          for ( k = j + 1; k < X.jsize( ); k++ )
-          {    if ( X[k].first != X[j].first || X[k].second != X[j].second ) break;
-               if ( X[k].third != X[j].third ) break;    }
-          if ( k - j > 1 )
-          {    for ( int64_t l = j; l < k; l++ ) {
-                    dup1.insert( X[l].fourth );
-              }
-               ndups += k - j - 1;
-               Bool inter = False;
-               int32_t b = bc[ X[j].fourth ];
-               for ( int64_t l = j + 1; l < k; l++ )
-               {    if ( b == 0 ) b = bc[ X[l].fourth ];
-                    else if ( bc[ X[l].fourth ] != b ) inter = True;    }
-               if (inter) interdups += k - j - 1;
-               if (verbose)
-               {    Bool print = False;
-                    const int print_freq = 10000;
-                    for ( int64_t l = j; l < k; l++ )
-                         if ( randomx( ) % print_freq == 0 ) print = True;
-                    if (print)
-                    {    cout << "\nduplicate group:\n";
-                         {    for ( int64_t l = j; l < k; l++ )
-                              {    cout << "[" << l-j+1 << "] " << X[l].fourth
-                                        << endl;    }    }    }    }    }
-          j = k - 1;    }
-     if ( ndups > 0 )
-          interdup_rate = double(interdups) / double(ndups);
-     else
-          interdup_rate = 0.0;
-
-     PRINT(dup1.size());
+          if ( X[j].hi != DUP_KEY_NONE ) X[nplaced++] = X[j];
+     X.resize(nplaced);
+     cout << Date( ) << ": sorting " << nplaced << " placements, mem = "
+          << MemUsageGBString( ) << ", peak = " << PeakMemUsageGBString( ) << endl;
+     ParallelRadixSort( X, 10, []( const DupKey& x, const int d )
+          { return int( d < 2 ? ( x.lo >> ( 48 + 8*d ) ) & 255
+               : ( x.hi >> ( 8 * (d-2) ) ) & 255 ); },
+          []( const DupKey& x, const DupKey& y )
+          { return x.hi < y.hi || ( x.hi == y.hi && x.lo < y.lo ); } );
+
+     // Cut X into blocks at group boundaries.
+
+     const int nb = Max( (int64_t) 1,
+          Min( (int64_t) omp_get_max_threads( ), nplaced / 100000 ) );
+     vec<int64_t> start( nb + 1 );
+     for ( int bl = 0; bl <= nb; bl++ )
+     {    int64_t j = nplaced * bl / nb;
+          while ( j > 0 && j < nplaced && X[j].SameGroup( X[j-1] ) ) j++;
+          start[bl] = j;    }
+
+     // Mark reads in duplicate groups.
+
+     cout << Date( ) << ": marking dups, mem = " << MemUsageGBString( )
+          << ", peak = " << PeakMemUsageGBString( ) << endl;
+     vec<uint64_t> dup1( ( bases.size( ) + 63 ) / 64, 0 );
+     int64_t ndups = 0, interdups = 0, dup_reads = 0;
+     #pragma omp parallel for schedule(dynamic,1) \
+          reduction(+:ndups,interdups,dup_reads)
+     for ( int bl = 0; bl < nb; bl++ )
+     {    for ( int64_t j = start[bl]; j < start[bl+1]; j++ )
+          {    int64_t k;
+               for ( k = j + 1; k < nplaced; k++ )
+                    if ( !X[k].SameGroup( X[j] ) ) break;
+               if ( k - j > 1 )
+               {    for ( int64_t l = j; l < k; l++ )
+                    {    const int64_t id = X[l].Id( );
+                         __sync_fetch_and_or(
+                              &dup1[id >> 6], uint64_t(1) << ( id & 63 ) );    }
+                    dup_reads += k - j;
+                    ndups += k - j - 1;
+                    Bool inter = False;
+                    int32_t b = bc[ X[j].Id( ) ];
+                    for ( int64_t l = j + 1; l < k; l++ )
+                    {    if ( b == 0 ) b = bc[ X[l].Id( ) ];
+                         else if ( bc[ X[l].Id( ) ] != b ) inter = True;    }
+                    if (inter) interdups += k - j - 1;
+                    if (verbose)
+                    {
+                         #pragma omp critical
+                         {    Bool print = False;
+                              const int print_freq = 10000;
+                              for ( int64_t l = j; l < k; l++ )
+                                   if ( randomx( ) % print_freq == 0 ) print = True;
+                              if (print)
+                              {    cout << "\nduplicate group:\n";
+                                   for ( int64_t l = j; l < k; l++ )
+                                   {    cout << "[" << l-j+1 << "] " << X[l].Id( )
+                                             << endl;    }    }    }    }    }
+               j = k - 1;    }    }
+     interdup_rate = ( ndups > 0 ? double(interdups) / double(ndups) : 0.0 );
+     PRINT(dup_reads);
 
      // Compute qsums.
 
-     cout << Date( ) << ": computing qsums" << endl;
-     vec<int> qsum( X.size( ), 0 );
-     const int64_t batch = 100000;
-     auto quals_clone = quals;
-     auto comp = []( quad<int,int,int,int64_t>& t1, quad<int,int,int,int64_t>& t2) {
-           int result = compare(t1.fourth,t2.fourth);
-           if ( !result ) result = compare(t1.third,t2.third);
-           if ( !result ) result = compare(t1.second,t2.second);
-           if ( !result ) result = compare(t1.first,t2.first);
-           return result;
-     };
-     cout << Date() << ": ...sorting" << endl;
-     sortInPlaceParallel( X.begin(), X.end(), comp);
-     cout << Date() << ": ...summing" << endl;
-     #pragma omp parallel for schedule(dynamic,1) firstprivate(quals_clone)
-     for ( int64_t bi = 0; bi < X.jsize( ); bi += batch )
-     {    qualvector q;
-          for ( int64_t j = bi; j < Min( bi + batch, X.jsize( ) ); j++ )
-          {
-               int64_t id1 = X[j].fourth;
-               if ( dup1.count( id1 ) == 0 ) continue;
-               int64_t id2 = ( id1 % 2 == 0 ? id1 + 1 : id1 - 1 );
-               quals_clone[id1].unpack(&q);
-               for ( int l = 0; l < (int) q.size( ); l++ )
-                    qsum[id1] += q[l];
-               quals_clone[id2].unpack(&q);
-               for ( int l = 0; l < (int) q.size( ); l++ )
-                    qsum[id1] += q[l];    }    }
+     cout << Date( ) << ": computing qsums, mem = " << MemUsageGBString( )
+          << ", peak = " << PeakMemUsageGBString( ) << endl;
+     vec<int> qsum( bases.size( ), 0 );
+     {    const int64_t batch = 100000;
+          const int64_t N = bases.size( );
+          auto quals_clone = quals;
+          #pragma omp parallel for schedule(dynamic,1) firstprivate(quals_clone)
+          for ( int64_t bi = 0; bi < N; bi += batch )
+          {    qualvector q;
+               for ( int64_t id1 = bi; id1 < Min( bi + batch, N ); id1++ )
+               {    if ( !( dup1[id1 >> 6] >> ( id1 & 63 ) & 1 ) ) continue;
+                    int64_t id2 = ( id1 % 2 == 0 ? id1 + 1 : id1 - 1 );
+                    quals_clone[id1].unpack(&q);
+                    for ( int l = 0; l < (int) q.size( ); l++ ) qsum[id1] += q[l];
+                    quals_clone[id2].unpack(&q);
+                    for ( int l = 0; l < (int) q.size( ); l++ )
+                         qsum[id1] += q[l];    }    }    }
+     Destroy(dup1);
 
+     // Complete duplicate identification.  Groups with a tie are set aside so
+     // that the reads in them can be compared serially.
 
-     // Complete duplicate identification.
-     sortInPlaceParallel( X.begin(), X.end() );
+     cout << Date( ) << ": finalizing dups, mem = " << MemUsageGBString( )
+          << ", peak = " << PeakMemUsageGBString( ) << endl;
+     vec<vec<pair<int64_t,int64_t>>> ties(nb);
+     #pragma omp parallel for schedule(dynamic,1)
+     for ( int bl = 0; bl < nb; bl++ )
+     {    for ( int64_t j = start[bl]; j < start[bl+1]; j++ )
+          {    int64_t k;
+               for ( k = j + 1; k < nplaced; k++ )
+                    if ( !X[k].SameGroup( X[j] ) ) break;
+               int64_t best = j;
+               int q = qsum[ X[j].Id( ) ];
+               Bool tie = False;
+               for ( int64_t l = j + 1; l < k; l++ )
+               {    if ( qsum[ X[l].Id( ) ] == q )
+                    {    tie = True;
+                         if ( X[l].Id( ) < X[best].Id( ) ) best = l;    }
+                    else if ( qsum[ X[l].Id( ) ] > q )
+                    {    q = qsum[ X[l].Id( ) ];
+                         best = l;    }    }
+               if (tie) ties[bl].push( j, k );
+               for ( int64_t l = j; l < k; l++ )
+                    if ( l != best ) dup[ X[l].Id( )/2 ] = True;
+               j = k - 1;    }    }
+
+     // Check for artifactual duplicates.  Note that we only test this for the
+     // groups having a tie.
 
-     cout << Date( ) << ": finalizing dups" << endl;
      vec< triple<basevector,qualvector,int64_t> > qb;
      vec<Bool> art( bases.size( )/2, False );
-     for ( int64_t j = 0; j < X.jsize( ); j++ )
-     {    int64_t k;
-          for ( k = j + 1; k < X.jsize( ); k++ )
-          {    if ( X[k].first != X[j].first || X[k].second != X[j].second ) break;
-               if ( X[k].third != X[j].third ) break;    }
-
-          for ( int64_t l = j; l < k; l++ )
-          {    if ( l % 100000000 == 0 )
-               {    cout << Date( ) << ": start batch " << l/100000000 + 1 << " of "
-                         << X.size( )/100000000 << endl;    }    }
-
-          if ( X[j].first < 0 )
-          {    j = k - 1;
-               continue;    }
-
-          int64_t best = j;
-          int q = qsum[X[j].fourth];
-
-          // Check for tie.  Note that we only test this for the winners.
-
-          Bool tie = False;
-          for ( int64_t l = j + 1; l < k; l++ )
-          {    if ( qsum[X[l].fourth] == q )
-               {    tie = True;
-                    if ( X[l].fourth < X[best].fourth ) best = l;    }
-               else if ( qsum[X[l].fourth] > q )
-               {    q = qsum[X[l].fourth];
-                    best = l;    }    }
-          if (tie)
-          {    qb.resize( k - j );
-               for ( int64_t l = j; l < k; l++ )
-               {    qb[l-j].first = bases[ X[l].fourth ];
-                    quals[ X[l].fourth ].unpack( &qb[l-j].second );
-                    qb[l-j].third = X[l].fourth/2;    }
-               Sort(qb);
-               for ( int m = 0; m < (int) qb.isize( ); m++ )
-               {    int n;
-                    for ( n = m + 1; n < (int) qb.isize( ); n++ )
-                    {    if ( qb[n].first != qb[m].first ) break;
-                         if ( qb[n].second != qb[m].second ) break;    }
-                    for ( int x = m + 1; x < n; x++ )
-                         art[ qb[x].third ] = True;
-                    m = n - 1;    }    }
+     for ( int bl = 0; bl < nb; bl++ )
+     for ( auto t : ties[bl] )
+     {    const int64_t j = t.first, k = t.second;
+          qb.resize( k - j );
           for ( int64_t l = j; l < k; l++ )
-               if ( l != best ) dup[ X[l].fourth/2 ] = True;
-          j = k - 1;    }
-     
+          {    qb[l-j].first = bases[ X[l].Id( ) ];
+               quals[ X[l].Id( ) ].unpack( &qb[l-j].second );
+               qb[l-j].third = X[l].Id( )/2;    }
+          Sort(qb);
+          for ( int m = 0; m < (int) qb.isize( ); m++ )
+          {    int n;
+               for ( n = m + 1; n < (int) qb.isize( ); n++ )
+               {    if ( qb[n].first != qb[m].first ) break;
+                    if ( qb[n].second != qb[m].second ) break;    }
+               for ( int x = m + 1; x < n; x++ )
+                    art[ qb[x].third ] = True;
+               m = n - 1;    }    }
+
+     // Compute stats.
+
      double dup_perc = 100.0 * Sum(dup) / ( bases.size( )/2 );
      cout << setiosflags(ios::fixed) << setprecision(2)
           << dup_perc  << resetiosflags(ios::fixed)
           << "% of pairs appear to be duplicates" << endl;
      StatLogger::log( "dup_perc", dup_perc, "Pct duplicate", true );
-     
      cout << setiosflags(ios::fixed) << setprecision(2)
-          << ( 100.0 * interdups ) / ndups << resetiosflags(ios::fixed)
+          << 100.0 * interdup_rate << resetiosflags(ios::fixed)
           << "% of duplicates involve multiple barcodes" << endl;
-     StatLogger::log( "interdup_perc", interdup_rate*100.0, "Pct multi-bc duplicates", false );
-
+     StatLogger::log(
+          "interdup_perc", interdup_rate*100.0, "Pct multi-bc duplicates", false );
      double art_dup_perc = 100.0 * Sum(art) / ( bases.size( )/2 );
      cout << setiosflags(ios::fixed) << setprecision(2)
           << art_dup_perc << resetiosflags(ios::fixed)
           << "% of pairs appear to be artifactual duplicates" << endl;
      StatLogger::log( "art_dup_perc", art_dup_perc, "Pct artifactual dups", false );
-     
      if ( double(Sum(art)) / ( bases.size( ) / 2 ) > 0.01 )
      {    cout << "\nWARNING: Too many of your reads appear to be artifactual "
                << "duplicates.\n";
           cout << "It may be that your input files are damaged.\n\n";    }
      cout << Date( ) << ": done marking dups, time used = " << TimeSince(clock)
-          << endl;
+          << ", peak mem = " << PeakMemUsageGBString( ) << endl;    }
 
 }
 
-template< class VB, class VQ>
-void MarkDups( VB& bases, VQ& quals, ReadPathVecX& paths, const HyperBasevectorX& hb, const vec<int32_t>& bc,
-     vec<Bool>& dup, double& interdup_rate, const Bool verbose)
+template< class VB, class VQ, class VP >
+void MarkDups( VB& bases, VQ& quals, VP& paths, const vec<int32_t>& bc,
+     vec<Bool>& dup, double& interdup_rate, const Bool verbose )
 {
-     cout << Date( ) << ": MarkDups, version 2" << endl;
+     cout << Date( ) << ": MarkDups, version 1" << endl;
 
      // Heuristics.
 
@@ -612,174 +623,50 @@ void MarkDups( VB& bases, VQ& quals, ReadPathVecX& paths, const HyperBasevectorX
 
      // Prepare data structure that will allow duplicate identification.
 
-     vec< quad<int,int,int,int64_t> > X( bases.size( ) ); // (e,offset,head2,id1)
+     vec<DupKey> X( bases.size( ) );
      cout << Date( ) << ": making X" << endl;
      #pragma omp parallel for
      for ( int64_t id1 = 0; id1 < (int64_t) bases.size( ); id1++ )
      {    int64_t id2 = ( id1 % 2 == 0 ? id1 + 1 : id1 - 1 );
-          ReadPath p; paths.unzip(p,hb,id1); // RPVX
-          if ( p.size( ) == 0 ) X[id1] = make_quad( -1, -1, -1, -1 );
+          const ReadPath& p = paths[id1];
+          if ( p.size( ) == 0 ) X[id1].hi = X[id1].lo = DUP_KEY_NONE;
           else
           {    int n = 0;
                for ( int j = 0; j < BHEAD; j++ )
                {    n *= 4;
                     n += bases[id2][j];    }
-               X[id1] = make_quad( p[0], p.getOffset( ), n, id1 );    }    }
+               X[id1] = MakeDupKey( p[0], p.getOffset( ), n, id1 );    }    }
+     MarkDupsCore( bases, quals, X, bc, dup, interdup_rate, verbose, clock );    }
 
-     // Scoping.
-
-     int64_t ndups = 0, interdups = 0;
-     vec<int> qsum;
-     {
-          // Sort, then mark dups.
-
-          cout << Date( ) << ": sorting, mem = " << MemUsageGBString( )
-               << ", peak = " << PeakMemUsageGBString( ) << endl;
-          sortInPlaceParallel( X.begin(), X.end() );
-          cout << Date( ) << ": marking dups, mem = " << MemUsageGBString( )
-               << ", peak = " << PeakMemUsageGBString( ) << endl;
-          std::set< int64_t > dup1;
-          for ( int64_t j = 0; j < X.jsize( ); j++ )
-          {    if ( X[j].first < 0 ) continue;
-               int64_t k;
-               for ( k = j + 1; k < X.jsize( ); k++ )
-               {    if ( X[k].first != X[j].first || X[k].second != X[j].second ) 
-                         break;
-                    if ( X[k].third != X[j].third ) break;    }
-               if ( k - j > 1 )
-               {    for ( int64_t l = j; l < k; l++ ) {
-                         dup1.insert( X[l].fourth );
-                   }
-                    ndups += k - j - 1;
-                    Bool inter = False;
-                    int32_t b = bc[ X[j].fourth ];
-                    for ( int64_t l = j + 1; l < k; l++ )
-                    {    if ( b == 0 ) b = bc[ X[l].fourth ];
-                         else if ( bc[ X[l].fourth ] != b ) inter = True;    }
-                    if (inter) interdups += k - j - 1;
-                    if (verbose)
-                    {    Bool print = False;
-                         const int print_freq = 10000;
-                         for ( int64_t l = j; l < k; l++ )
-                              if ( randomx( ) % print_freq == 0 ) print = True;
-                         if (print)
-                         {    cout << "\nduplicate group:\n";
-                              {    for ( int64_t l = j; l < k; l++ )
-                                   {    cout << "[" << l-j+1 << "] " << X[l].fourth
-                                             << endl;    }    }    }    }    }
-               j = k - 1;    }
-          interdup_rate = double(interdups) / double(ndups);
-          PRINT(dup1.size());
-     
-          // Compute qsums.
+template< class VB, class VQ>
+void MarkDups( VB& bases, VQ& quals, ReadPathVecX& paths, const HyperBasevectorX& hb, const vec<int32_t>& bc,
+     vec<Bool>& dup, double& interdup_rate, const Bool verbose)
+{
+     cout << Date( ) << ": MarkDups, version 2" << endl;
 
-          cout << Date( ) << ": computing qsums, mem = " << MemUsageGBString( )
-               << ", peak = " << PeakMemUsageGBString( ) << endl;
-          qsum.resize( X.size( ), 0 );
-          const int64_t batch = 100000;
-          auto quals_clone = quals;
-          auto comp = []( 
-               quad<int,int,int,int64_t>& t1, quad<int,int,int,int64_t>& t2) {
-               int result = compare(t1.fourth,t2.fourth);
-               if ( !result ) result = compare(t1.third,t2.third);
-               if ( !result ) result = compare(t1.second,t2.second);
-               if ( !result ) result = compare(t1.first,t2.first);
-               return result;
-          };
-          cout << Date() << ": ...sorting" << endl;
-          sortInPlaceParallel( X.begin(), X.end(), comp);
-          cout << Date() << ": ...summing" << endl;
-          #pragma omp parallel for schedule(dynamic,1) firstprivate(quals_clone)
-          for ( int64_t bi = 0; bi < X.jsize( ); bi += batch )
-          {    qualvector q;
-               for ( int64_t j = bi; j < Min( bi + batch, X.jsize( ) ); j++ )
-               {
-                    int64_t id1 = X[j].fourth;
-                    if ( dup1.count( id1 ) == 0 ) continue;
-                    int64_t id2 = ( id1 % 2 == 0 ? id1 + 1 : id1 - 1 );
-                    quals_clone[id1].unpack(&q);
-                    for ( int l = 0; l < (int) q.size( ); l++ ) qsum[id1] += q[l];
-                    quals_clone[id2].unpack(&q);
-                    for ( int l = 0; l < (int) q.size( ); l++ )
-                         qsum[id1] += q[l];    }    }    }
+     // Heuristics.
 
-     // Complete duplicate identification.
+     const int BHEAD = 5;
 
-     sortInPlaceParallel( X.begin(), X.end() );
-     cout << Date( ) << ": finalizing dups, mem = " << MemUsageGBString( )
-          << ", peak = " << PeakMemUsageGBString( ) << endl;
-     vec< triple<basevector,qualvector,int64_t> > qb;
-     vec<Bool> art( bases.size( )/2, False );
-     for ( int64_t j = 0; j < X.jsize( ); j++ )
-     {    int64_t k;
-          for ( k = j + 1; k < X.jsize( ); k++ )
-          {    if ( X[k].first != X[j].first || X[k].second != X[j].second ) break;
-               if ( X[k].third != X[j].third ) break;    }
+     // Start.
 
-          for ( int64_t l = j; l < k; l++ )
-          {    if ( l % 100000000 == 0 )
-               {    cout << Date( ) << ": start batch " << l/100000000 + 1 << " of "
-                         << X.size( )/100000000 + 1 << endl;    }    }
-
-          if ( X[j].first < 0 )
-          {    j = k - 1;
-               continue;    }
-
-          int64_t best = j;
-          int q = qsum[X[j].fourth];
-
-          // Check for tie.  Note that we only test this for the winners.
-
-          Bool tie = False;
-          for ( int64_t l = j + 1; l < k; l++ )
-          {    if ( qsum[X[l].fourth] == q )
-               {    tie = True;
-                    if ( X[l].fourth < X[best].fourth ) best = l;    }
-               else if ( qsum[X[l].fourth] > q )
-               {    q = qsum[X[l].fourth];
-                    best = l;    }    }
-          if (tie)
-          {    qb.resize( k - j );
-               for ( int64_t l = j; l < k; l++ )
-               {    qb[l-j].first = bases[ X[l].fourth ];
-                    quals[ X[l].fourth ].unpack( &qb[l-j].second );
-                    qb[l-j].third = X[l].fourth/2;    }
-               Sort(qb);
-               for ( int m = 0; m < (int) qb.isize( ); m++ )
-               {    int n;
-                    for ( n = m + 1; n < (int) qb.isize( ); n++ )
-                    {    if ( qb[n].first != qb[m].first ) break;
-                         if ( qb[n].second != qb[m].second ) break;    }
-                    for ( int x = m + 1; x < n; x++ )
-                         art[ qb[x].third ] = True;
-                    m = n - 1;    }    }
-          for ( int64_t l = j; l < k; l++ )
-               if ( l != best ) dup[ X[l].fourth/2 ] = True;
-          j = k - 1;    }
+     double clock = WallClockTime( );
+     dup.resize_and_set( bases.size( ) / 2, False );
 
-     // Compute stats.
+     // Prepare data structure that will allow duplicate identification.
 
-     double dup_perc = 100.0 * Sum(dup) / ( bases.size( )/2 );
-     cout << setiosflags(ios::fixed) << setprecision(2)
-          << dup_perc  << resetiosflags(ios::fixed)
-          << "% of pairs appear to be duplicates" << endl;
-     StatLogger::log( "dup_perc", dup_perc, "Pct duplicate", true );
-     cout << setiosflags(ios::fixed) << setprecision(2)
-          << ( 100.0 * interdups ) / ndups << resetiosflags(ios::fixed)
-          << "% of duplicates involve multiple barcodes" << endl;
-     StatLogger::log( 
-          "interdup_perc", interdup_rate*100.0, "Pct multi-bc duplicates", false );
-     double art_dup_perc = 100.0 * Sum(art) / ( bases.size( )/2 );
-     cout << setiosflags(ios::fixed) << setprecision(2)
-          << art_dup_perc << resetiosflags(ios::fixed)
-          << "% of pairs appear to be artifactual duplicates" << endl;
-     StatLogger::log( "art_dup_perc", art_dup_perc, "Pct artifactual dups", false );
-     if ( double(Sum(art)) / ( bases.size( ) / 2 ) > 0.01 )
-     {    cout << "\nWARNING: Too many of your reads appear to be artifactual "
-               << "duplicates.\n";
-          cout << "It may be that your input files are damaged.\n\n";    }
-     cout << Date( ) << ": done marking dups, time used = " << TimeSince(clock)
-          << endl;    }
+     vec<DupKey> X( bases.size( ) );
+     cout << Date( ) << ": making X" << endl;
+     paths.forEachPath( hb, 0, bases.size( ), [&]( int64_t id1, const ReadPath& p )
+     {    int64_t id2 = ( id1 % 2 == 0 ? id1 + 1 : id1 - 1 );
+          if ( p.size( ) == 0 ) X[id1].hi = X[id1].lo = DUP_KEY_NONE;
+          else
+          {    int n = 0;
+               for ( int j = 0; j < BHEAD; j++ )
+               {    n *= 4;
+                    n += bases[id2][j];    }
+               X[id1] = MakeDupKey( p[0], p.getOffset( ), n, id1 );    }    } );
+     MarkDupsCore( bases, quals, X, bc, dup, interdup_rate, verbose, clock );    }
 
 template void MarkDups( VirtualMasterVec<basevector>& bases,
      VirtualMasterVec<PQVec>&, ReadPathVecX&, const HyperBasevectorX&, const vec<int32_t>&,
@@ -980,23 +867,7 @@ void AllTinksCore( const HyperBasevectorX& hb, const vec<int>& inv,
           // compute intersection of barcode vectors
           // this works because BOTH vectors are sorted
           // and all elements are unique
-          auto & b1 = ebcx[e1];
-          auto & b2 = ebcx[e2];
-          auto p1 = b1.begin();
-          auto p2 = b2.begin();
-          int common = 0;
-          while (p1 != b1.end() && p2 != b2.end() ) {
-               if ( *p1 == *p2 ) {
-                    common++;
-                    p1++;
-                    p2++;
-               }
-               else if ( *p1 < *p2 )
-                    p1++;
-               else
-                    p2++;
-          }
-          qept[i].third = common;
+          qept[i].third = SortedMeetSize( ebcx[e1], ebcx[e2] );
      }
 
      // Sort and write.
@@ -0,0 +1,86 @@
+// Copyright (c) 2016 10X Genomics, Inc. All rights reserved.
+
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "10X/SortedIntSets.h"
+
+namespace {
+
+// Use galloping if one set is at least this many times bigger than the other.
+
+const int64_t GALLOP_RATIO = 32;
+
+// Call found(x) for each x in both a and b, in order, where na is much smaller
+// than nb.
+
+template<class F> void Gallop( const int* a, const int64_t na,
+     const int* b, const int64_t nb, F found )
+{    int64_t j = 0;
+     for ( int64_t i = 0; i < na && j < nb; i++ )
+     {    const int x = a[i];
+          int64_t lo = j, step = 1;
+          while ( lo + step < nb && b[ lo + step ] < x )
+          {    lo += step;
+               step *= 2;    }
+          j = std::lower_bound( b + lo, b + Min( lo + step + 1, nb ), x ) - b;
+          if ( j < nb && b[j] == x ) found( b[j++] );    }    }
+
+// Call found(x) for each x in both a and b, in order, na and nb being
+// comparable.
+
+template<class F> void Merge( const int* a, const int64_t na,
+     const int* b, const int64_t nb, F found )
+{    int64_t i = 0, j = 0;
+
+     #if defined(__SSE2__)
+     const int64_t na4 = na & ~int64_t(3), nb4 = nb & ~int64_t(3);
+     while ( i < na4 && j < nb4 )
+     {    const __m128i va = _mm_loadu_si128( (const __m128i*) ( a + i ) );
+          const __m128i vb = _mm_loadu_si128( (const __m128i*) ( b + j ) );
+          const __m128i m = _mm_or_si128(
+               _mm_or_si128( _mm_cmpeq_epi32( va, vb ), _mm_cmpeq_epi32(
+                    va, _mm_shuffle_epi32( vb, _MM_SHUFFLE(0,3,2,1) ) ) ),
+               _mm_or_si128( _mm_cmpeq_epi32(
+                    va, _mm_shuffle_epi32( vb, _MM_SHUFFLE(1,0,3,2) ) ),
+                    _mm_cmpeq_epi32(
+                    va, _mm_shuffle_epi32( vb, _MM_SHUFFLE(2,1,0,3) ) ) ) );
+          const int mask = _mm_movemask_ps( _mm_castsi128_ps(m) );
+          for ( int k = 0; k < 4; k++ )
+               if ( mask & ( 1 << k ) ) found( a[i+k] );
+          const int amax = a[i+3], bmax = b[j+3];
+          if ( amax <= bmax ) i += 4;
+          if ( bmax <= amax ) j += 4;    }
+     #endif
+
+     while ( i < na && j < nb )
+     {    if ( a[i] < b[j] ) i++;
+          else if ( b[j] < a[i] ) j++;
+          else
+          {    found( a[i] );
+               i++, j++;    }    }    }
+
+template<class F> void Intersect( const int* a, int64_t na,
+     const int* b, int64_t nb, F found )
+{    if ( na > nb )
+     {    std::swap( a, b );
+          std::swap( na, nb );    }
+     if ( na == 0 ) return;
+     if ( nb >= GALLOP_RATIO * na ) Gallop( a, na, b, nb, found );
+     else Merge( a, na, b, nb, found );    }
+
+}
+
+int64_t SortedMeetSize( const int* a, const int64_t na,
+     const int* b, const int64_t nb )
+{    int64_t n = 0;
+     Intersect( a, na, b, nb, [&]( const int ) { n++; } );
+     return n;    }
+
+void SortedIntersection( const int* a, const int64_t na,
+     const int* b, const int64_t nb, vec<int>& c )
+{    c.clear( );
+     Intersect( a, na, b, nb,
+          [&]( const int x ) { c.push_back(x); } );    }
@@ -0,0 +1,35 @@
+// Copyright (c) 2016 10X Genomics, Inc. All rights reserved.
+
+// Sets of ints held as sorted arrays without duplicates, such as the barcode
+// list of an edge in ebcx.
+//
+// SortedMeetSize and SortedIntersection are intersection kernels for two such
+// sets.  When one set is much smaller than the other, each of its elements is
+// found in the other by galloping.  Otherwise the two are merged four elements
+// at a time, comparing each block of one against all rotations of a block of
+// the other with SSE2.
+
+#ifndef TENX_SORTED_INT_SETS_H
+#define TENX_SORTED_INT_SETS_H
+
+#include "CoreTools.h"
+
+int64_t SortedMeetSize( const int* a, const int64_t na,
+     const int* b, const int64_t nb );
+
+void SortedIntersection( const int* a, const int64_t na,
+     const int* b, const int64_t nb, vec<int>& c );
+
+template<class V> inline const int* SortedSetData( const V& x )
+{    return x.empty( ) ? nullptr : &x[0];    }
+
+template<class A, class B> inline int64_t SortedMeetSize( const A& a, const B& b )
+{    return SortedMeetSize(
+          SortedSetData(a), a.size( ), SortedSetData(b), b.size( ) );    }
+
+template<class A, class B>
+inline void SortedIntersection( const A& a, const B& b, vec<int>& c )
+{    SortedIntersection(
+          SortedSetData(a), a.size( ), SortedSetData(b), b.size( ), c );    }
+
+#endif
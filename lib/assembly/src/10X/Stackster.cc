@@ -284,8 +284,11 @@ void Stackster( const int e1, const int e2, const vec<basevector>& edges,
      const vec<int>& kmers, const vec<int>& inv, const vec<Bool>& dup,
      VP const& paths, VPI const& paths_index, vec<basevector>& closures, 
      vec<int>& trim, const int VERBOSITY, const Bool ALT, const Bool EXP,
-     const vec< pair<int64_t,Bool> >& idsfw2 )
+     const vec< pair<int64_t,Bool> >& idsfw2, const double deadline )
 {
+     auto out_of_time = [&]( )
+          { return deadline > 0 && WallClockTime( ) > deadline; };
+
      // Create the read set, including partners that are off the ends.
 
      if ( VERBOSITY >= 1 ) cout << Date( ) << ": creating read set" << endl;
@@ -330,7 +333,8 @@ void Stackster( const int e1, const int e2, const vec<basevector>& edges,
      vecbasevector basesx;
      VecPQVec qualsx;
      for ( int i = 0; i < idsfw.isize( ); i++ )
-     {    int64_t id = idsfw[i].first;
+     {    if ( out_of_time( ) ) return;
+          int64_t id = idsfw[i].first;
           ids.push_back( id );
           basesx.push_back( bases[id] );
           qualsx.push_back( quals[id] );    }
@@ -361,6 +365,7 @@ void Stackster( const int e1, const int e2, const vec<basevector>& edges,
 
      // Build read stacks.
 
+     if ( out_of_time( ) ) return;
      if ( VERBOSITY >= 1 ) 
           cout << "\n" << Date( ) << ": building stacks" << endl;
      vec<readstack> stacks(2);
@@ -381,6 +386,7 @@ void Stackster( const int e1, const int e2, const vec<basevector>& edges,
 
           // Walk the stack.
 
+          if ( out_of_time( ) ) return;
           vec<int> start;
           basevector E = edges[spass-1];
           if ( spass == 2 ) E.ReverseComplement( );
@@ -519,7 +525,8 @@ void Stackster( const int e1, const int e2, const vec<basevector>& edges,
           // Look at every read kmer.
 
           for ( int r = 0; r < s2.Rows( ); r++ )
-          {    for ( int l = 0; l <= s2.Cols( ) - MM; l++ )
+          {    if ( out_of_time( ) ) return;
+               for ( int l = 0; l <= s2.Cols( ) - MM; l++ )
                {    
                     // Is kmer defined?
 
@@ -711,6 +718,7 @@ void Stackster( const int e1, const int e2, const vec<basevector>& edges,
 
      // Merge stacks.
 
+     if ( out_of_time( ) ) return;
      const int MAX_OFFSETS = 3;
      if ( offsets.isize( ) <= MAX_OFFSETS )
      {    for ( int j = 0; j < offsets.isize( ); j++ )
@@ -933,7 +941,7 @@ template void Stackster( const int e1, const int e2, const vec<basevector>& edge
      VirtualMasterVec<ReadPath> const& paths, 
      VirtualMasterVec<ULongVec> const& paths_index, vec<basevector>& closures, 
      vec<int>& trim, const int VERBOSITY, const Bool ALT, const Bool EXP,
-     const vec< pair<int64_t,Bool> >& idsfw2 );
+     const vec< pair<int64_t,Bool> >& idsfw2, const double deadline );
 
 template void Stackster( const int e1, const int e2, const vec<basevector>& edges,
      MasterVec<basevector> const& bases, MasterVec<PQVec> const& quals,
@@ -942,7 +950,7 @@ template void Stackster( const int e1, const int e2, const vec<basevector>& edge
      MasterVec<ReadPath> const& paths, MasterVec<ULongVec> const& paths_index,
      vec<basevector>& closures, vec<int>& trim, const int VERBOSITY, 
      const Bool ALT, const Bool EXP,
-     const vec< pair<int64_t,Bool> >& idsfw2 );
+     const vec< pair<int64_t,Bool> >& idsfw2, const double deadline );
 
 template void Stackster( const int e1, const int e2, const vec<basevector>& edges,
      MasterVec<basevector> const& bases, SubsetMasterVec<PQVec> const& quals,
@@ -950,4 +958,5 @@ template void Stackster( const int e1, const int e2, const vec<basevector>& edge
      const vec<int>& kmers, const vec<int>& inv, const vec<Bool>& dup,
      SubsetMasterVec<ReadPath> const& paths, SubsetMasterVec<ULongVec> const& paths_index,
      vec<basevector>& closures, vec<int>& trim, const int VERBOSITY, 
-     const Bool ALT, const Bool EXP, const vec< pair<int64_t,Bool> >& idsfw2 );
+     const Bool ALT, const Bool EXP, const vec< pair<int64_t,Bool> >& idsfw2,
+     const double deadline );
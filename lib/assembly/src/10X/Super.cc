@@ -19,6 +19,7 @@
 #include "10X/LineOO.h"
 #include "10X/PlaceReads.h"
 #include "10X/PullApart.h"
+#include "10X/SortedIntSets.h"
 #include "10X/Super.h"
 #include "10X/mergers/EdgeSupport.h"
 
@@ -2984,7 +2985,7 @@ void LineProx( const HyperBasevectorX& hb, const vec<int>& inv,
                          if ( i2 != i1 ) n.push_back(i2);    }    }    }
           UniqueSort(n);
           for ( int j = 0; j < n.isize( ); j++ )
-          {    int c = MeetSize( lbc[i1], lbc[ n[j] ] );
+          {    int c = SortedMeetSize( lbc[i1], lbc[ n[j] ] );
                if ( c >= MIN_LINKS ) lhood[i1].push( c, n[j] );    }
           ReverseSort( lhood[i1] );
           for ( int j = 1; j < lhood[i1].isize( ); j++ )
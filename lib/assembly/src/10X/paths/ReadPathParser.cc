@@ -98,15 +98,12 @@
 /**
  * @brief unzips a readpath at index in bitseq
  *
- * @param bitseq: const vec<unsigned char>&
+ * @param bitseq: const unsigned char*
  * @param rp: ReadPath&
  * @param hb: const HyperBasevectorX&
  * @param index: const int64_t
  */
-    void RPParser::LLunzip(const uCharArray& bitseq, ReadPath& rp, const HyperBasevectorX& hb, const int64_t index)const{
-        if (bitseq.size()==0)
-            exit(1);
-
+    void RPParser::LLunzip(const unsigned char* bitseq, ReadPath& rp, const HyperBasevectorX& hb, const int64_t index)const{
         // set numEdges
         rp.resize(bitseq[index],0); 
 
@@ -134,16 +131,13 @@
 /**
  * @brief unzips an edge list and offset at index in bitseq
  *
- * @param bitseq: const vec<unsigned char>&
+ * @param bitseq: const unsigned char*
  * @param rp: vec<int>&
  * @param offset: int&
  * @param hb: const HyperBasevectorX&
  * @param index: const int64_t
  */
-    void RPParser::LLunzip(const uCharArray& bitseq, vec<int>& rp, int& offset, const HyperBasevectorX& hb, const int64_t index) const{
-        if (bitseq.size()==0)
-            exit(1);
-        
+    void RPParser::LLunzip(const unsigned char* bitseq, vec<int>& rp, int& offset, const HyperBasevectorX& hb, const int64_t index) const{
         // set numEdges
         rp.resize(bitseq[index],0); 
 
@@ -200,14 +194,14 @@
 /**
  * @brief decodes a branch id using a fixed width encoding
  *
- * @param bitseq: const vec<unsigned char>&
+ * @param bitseq: const unsigned char*
  * @param sub_idx: unsigned int&
  * @param idx: int64_t&
  * @param sch: CODING_SCHEME
  *
  * @return 
  */
-    int RPParser::LLdecodeBranchId(const uCharArray& bitseq, unsigned int& sub_idx, int64_t& idx, CODING_SCHEME sch) const{
+    int RPParser::LLdecodeBranchId(const unsigned char* bitseq, unsigned int& sub_idx, int64_t& idx, CODING_SCHEME sch) const{
         int ret = 0;
         unsigned char word = bitseq[idx];
         if(sch == FIXED_WIDTH){
@@ -229,12 +223,12 @@
 /**
  * @brief gets an offset at a read index in the bitseq
  *
- * @param bitseq: const vec<unsigned char>&
+ * @param bitseq: const unsigned char*
  * @param idx: const int64_t
  *
  * @return 
  */
-    int RPParser::LLgetOffset(const uCharArray& bitseq, const int64_t idx) const{
+    int RPParser::LLgetOffset(const unsigned char* bitseq, const int64_t idx) const{
         if(LLgetNumEdges(bitseq,idx)>0){
             return (static_cast<int>((reinterpret_cast<const int16_t*>(&bitseq[idx+1])[0])));
         }
@@ -247,16 +241,16 @@
 /**
  * @brief gets the first edge for a read index in the bitseq
  *
- * @param bitseq:const vec<unsigned char>&
+ * @param bitseq: const unsigned char*
  * @param idx: const int64_t
  *
  * @return 
  */
-    int RPParser::LLgetFirstEdge(const uCharArray& bitseq, const int64_t idx) const{
+    int RPParser::LLgetFirstEdge(const unsigned char* bitseq, const int64_t idx) const{
         return (static_cast<int>((reinterpret_cast<const uint32_t*>(&bitseq[1+sizeof(int16_t)+idx])[0])));
     }
 
-    int RPParser::LLgetNumEdges(const uCharArray& bitseq, const int64_t idx) const {
+    int RPParser::LLgetNumEdges(const unsigned char* bitseq, const int64_t idx) const {
         return static_cast<int>(bitseq[idx]);
     }
 
@@ -269,12 +263,12 @@
 /**
  * @brief well formatted output, use only with readpathX
  *
- * @param bitseq: const vec<unsigned char>&
+ * @param bitseq: const unsigned char*
  * @param hb: const HyperBasevectorX&
  * @param messg: std::string
  * @param index: const int64_t
  */
-    void RPParser::LLprintMe(const uCharArray& bitseq,const HyperBasevectorX& hb, const std::string messg,const int64_t index) const {
+    void RPParser::LLprintMe(const unsigned char* bitseq,const HyperBasevectorX& hb, const std::string messg,const int64_t index) const {
         cout<<messg<<"[";
         int size = LLgetNumEdges(bitseq,index);
         cout<<"offset: "<<LLgetOffset(bitseq,index)<<" | numEdges: "<<size<<" | Edges: ";
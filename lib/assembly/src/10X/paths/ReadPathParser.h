@@ -18,9 +18,9 @@ class RPParser{
 
     /* A C C E S S O R S: U N C O M P R E S S O R S */
 
-    void LLunzip(const uCharArray& bitseq, ReadPath& rp, const HyperBasevectorX& hb, const int64_t index = 0)const;
+    void LLunzip(const unsigned char* bitseq, ReadPath& rp, const HyperBasevectorX& hb, const int64_t index = 0)const;
     
-    void LLunzip(const uCharArray& bitseq, vec<int>& rp, int& offset, const HyperBasevectorX& hb, const int64_t index = 0) const;
+    void LLunzip(const unsigned char* bitseq, vec<int>& rp, int& offset, const HyperBasevectorX& hb, const int64_t index = 0) const;
 
 
     /* E N C R Y P T I O N   A L G O R I T H M S */
@@ -28,23 +28,23 @@ class RPParser{
     // standard 2bit scheme OR huffman scheme
     void LLencodeBranchId(uCharArray& bitseq, const unsigned int& id, unsigned int& sub_idx, int64_t& idx, CODING_SCHEME sch=FIXED_WIDTH);
 
-    int LLdecodeBranchId(const uCharArray& bitseq, unsigned int& sub_idx, int64_t& idx, CODING_SCHEME sch=FIXED_WIDTH) const;
+    int LLdecodeBranchId(const unsigned char* bitseq, unsigned int& sub_idx, int64_t& idx, CODING_SCHEME sch=FIXED_WIDTH) const;
 
 
     /* A C C E S S O R S  &  M O D I F I E R S */
 
-    int LLgetOffset(const uCharArray& bitseq, const int64_t idx = 0) const;
+    int LLgetOffset(const unsigned char* bitseq, const int64_t idx = 0) const;
 
-    int LLgetFirstEdge(const uCharArray& bitseq, const int64_t idx = 0) const;
+    int LLgetFirstEdge(const unsigned char* bitseq, const int64_t idx = 0) const;
 
-    int LLgetNumEdges(const uCharArray& bitseq, const int64_t idx = 0) const; 
+    int LLgetNumEdges(const unsigned char* bitseq, const int64_t idx = 0) const; 
 
     int LLgetNumBytes(const uCharArray& bitseq) const;
 
     /* /1* S T D   O/P *1/ */
 
     // well formatted output, use only with RPX
-    void LLprintMe(const uCharArray& bitseq, const HyperBasevectorX& hb, const std::string messg="", const int64_t index=0) const;
+    void LLprintMe(const unsigned char* bitseq, const HyperBasevectorX& hb, const std::string messg="", const int64_t index=0) const;
 
 };
 
@@ -4,7 +4,9 @@
 // MakeDepend: cflags OMP_FLAGS
 
 #include "10X/paths/ReadPathVecX.h"
+#include "system/file/FileReader.h"
 #include <omp.h>
+#include <sys/mman.h>
 
 #define READPATHVECX_CC_
 #ifdef READPATHVECX_CC_
@@ -32,42 +34,42 @@
  *
  * @return 
  */
-uchararr_iterator ReadPathVecX::begin() { return ZippedData.begin(); }
+uchararr_iterator ReadPathVecX::begin() { assertInMemory(); return ZippedData.begin(); }
 
 /**
  * @brief return end itr to internal storage
  *
  * @return 
  */
-uchararr_iterator ReadPathVecX::end() { return ZippedData.end(); }
+uchararr_iterator ReadPathVecX::end() { assertInMemory(); return ZippedData.end(); }
 
 /**
  * @brief return begin const itr
  *
  * @return 
  */
-const_uchararr_iterator ReadPathVecX::begin() const { return ZippedData.begin(); }
+const_uchararr_iterator ReadPathVecX::begin() const { assertInMemory(); return ZippedData.begin(); }
 
 /**
  * @brief return end const itr
  *
  * @return 
  */
-const_uchararr_iterator ReadPathVecX::end() const { return ZippedData.end(); }
+const_uchararr_iterator ReadPathVecX::end() const { assertInMemory(); return ZippedData.end(); }
 
 /**
  * @brief return cbegin const itr
  *
  * @return 
  */
-const_uchararr_iterator ReadPathVecX::cbegin() const { return ZippedData.cbegin(); }
+const_uchararr_iterator ReadPathVecX::cbegin() const { assertInMemory(); return ZippedData.cbegin(); }
 
 /**
  * @brief return cend const itr
  *
  * @return 
  */
-const_uchararr_iterator ReadPathVecX::cend() const { return ZippedData.cend(); }
+const_uchararr_iterator ReadPathVecX::cend() const { assertInMemory(); return ZippedData.cend(); }
 
 /**
  * @brief iterator to a random read inside the compressed storage
@@ -77,6 +79,7 @@ const_uchararr_iterator ReadPathVecX::cend() const { return ZippedData.cend(); }
  * @return 
  */
 const_uchararr_iterator ReadPathVecX::accessItr(const int64_t read_id) const{
+    assertInMemory();
     ForceAssertLt(read_id,next_start_rid);
     ForceAssertGt(read_id+1, start_rid);
     int64_t floor_idx = (read_id-start_rid)/skip;
@@ -111,7 +114,7 @@ int64_t ReadPathVecX::accessIdx(const int64_t read_id) const{
     ForceAssertGt(read_id+1, start_rid);
     int64_t floor_idx = (read_id-start_rid)/skip;
 
-    int64_t idx = ZipIndex[floor_idx];
+    int64_t idx = zipIndex()[floor_idx];
     for(int64_t i = start_rid+floor_idx*skip; i<read_id; i++){
         jumpIdx(idx);
     }
@@ -124,7 +127,7 @@ int64_t ReadPathVecX::accessIdx(const int64_t read_id) const{
  * @param idx: int64_t&
  */
 void ReadPathVecX::jumpIdx(int64_t& idx) const{
-    unsigned char numEdges = ZippedData[idx];
+    unsigned char numEdges = zippedData()[idx];
     // this would change if branch id not standard
     idx += ( (static_cast<int>(numEdges)>0)?1+2+4+((numEdges-1)+3)/4:1 );
 }
@@ -138,7 +141,7 @@ void ReadPathVecX::jumpIdx(int64_t& idx) const{
 ReadPathVecX::ReadPathVecX(){
     start_rid = 0;
     next_start_rid = 0;
-    skip = 10;
+    skip = DEFAULT_SKIP;
 }
 
 /**
@@ -169,7 +172,7 @@ ReadPathVecX::ReadPathVecX(const int64_t sid, const int64_t numReads){
 ReadPathVecX::ReadPathVecX(const ReadPath& rp, const HyperBasevectorX& hb){
     start_rid = 0;
     next_start_rid = 0;
-    skip = 10;
+    skip = DEFAULT_SKIP;
     append(rp,hb);
 }
 
@@ -183,7 +186,7 @@ ReadPathVecX::ReadPathVecX(const ReadPath& rp, const HyperBasevectorX& hb){
 ReadPathVecX::ReadPathVecX(const vec<int>& edge_list, const int offset, const HyperBasevectorX& hb){
     start_rid = 0;
     next_start_rid = 0;
-    skip = 10;
+    skip = DEFAULT_SKIP;
     append(edge_list,offset,hb);
 }
 
@@ -195,7 +198,7 @@ ReadPathVecX::ReadPathVecX(const vec<int>& edge_list, const int offset, const Hy
 ReadPathVecX::ReadPathVecX(const ReadPathX rpx){
     start_rid = 0;
     next_start_rid = 0;
-    skip = 10;
+    skip = DEFAULT_SKIP;
     append(rpx);
 }
 
@@ -278,6 +281,7 @@ ReadPathVecX::ReadPathVecX(const String Fname){
  */
 void ReadPathVecX::reserve(const int64_t numReads){
     ForceAssertGe(numReads,0);
+    assertInMemory();
     start_rid = 0;
     next_start_rid = 0;
     ZipIndex.reserve(numReads/skip+3);
@@ -293,6 +297,7 @@ void ReadPathVecX::reserve(const int64_t numReads){
  */
 void ReadPathVecX::reserve(const int64_t sid, const int64_t numReads){
     ForceAssertGe(numReads,0);
+    assertInMemory();
     start_rid = sid;
     next_start_rid = sid;
     ZipIndex.reserve(numReads/skip+3);
@@ -345,8 +350,9 @@ void ReadPathVecX::append(const ReadPathVecX& rpvx){
     }
     if(rpvx.size()==0) // do nothing
         return;
+    assertInMemory();
     ZippedData.reserve(storageSize()+rpvx.storageSize());
-    ZippedData.insert(ZippedData.end(),rpvx.begin(),rpvx.end());
+    ZippedData.insert(ZippedData.end(),rpvx.zippedData(),rpvx.zippedData()+rpvx.storageSize());
     next_start_rid += rpvx.size();
     recompileZipIndex();
 }
@@ -359,11 +365,12 @@ void ReadPathVecX::append(const ReadPathVecX& rpvx){
 void ReadPathVecX::append(const vec<ReadPathVecX>& blocks){
     if(blocks.size()==0)
         return;
+    assertInMemory();
     int64_t totalStorage = storageSize();
     for(auto& bl: blocks) totalStorage += bl.storageSize();
     ZippedData.reserve(totalStorage);
     for(auto& bl: blocks){
-        ZippedData.insert(ZippedData.end(),bl.begin(),bl.end());
+        ZippedData.insert(ZippedData.end(),bl.zippedData(),bl.zippedData()+bl.storageSize());
         next_start_rid += bl.size();
     }
     recompileZipIndex();
@@ -555,7 +562,7 @@ void ReadPathVecX::parallel_append(const VReadPathVec& paths, const HyperBasevec
  * @param read_id: const int64_t
  */
 void ReadPathVecX::unzip(ReadPath& rp, const HyperBasevectorX& hb, const int64_t read_id) const{
-    LLunzip(ZippedData,rp,hb,accessIdx(read_id));
+    LLunzip(zippedData(),rp,hb,accessIdx(read_id));
 }
 
 /**
@@ -567,7 +574,7 @@ void ReadPathVecX::unzip(ReadPath& rp, const HyperBasevectorX& hb, const int64_t
  * @param read_id: const int64_t
  */
 void ReadPathVecX::unzip(vec<int>& edge_list, int& offset, const HyperBasevectorX& hb, const int64_t read_id) const {
-    LLunzip(ZippedData,edge_list,offset,hb,accessIdx(read_id));
+    LLunzip(zippedData(),edge_list,offset,hb,accessIdx(read_id));
 }
 
 /**
@@ -657,6 +664,11 @@ ReadPathVecX::ReadPathVecX(const ReadPathVecX& source){
     next_start_rid = source.next_start_rid;
     ZippedData = source.ZippedData;
     ZipIndex = source.ZipIndex;
+    mapping = source.mapping;
+    mappedData = source.mappedData;
+    mappedIndex = source.mappedIndex;
+    mappedDataSize = source.mappedDataSize;
+    mappedIndexSize = source.mappedIndexSize;
 }
 
 /**
@@ -674,6 +686,11 @@ ReadPathVecX& ReadPathVecX::operator=(const ReadPathVecX& source){
     next_start_rid = source.next_start_rid;
     ZippedData = source.ZippedData;
     ZipIndex = source.ZipIndex;
+    mapping = source.mapping;
+    mappedData = source.mappedData;
+    mappedIndex = source.mappedIndex;
+    mappedDataSize = source.mappedDataSize;
+    mappedIndexSize = source.mappedIndexSize;
     return *this;
 }
 /* U P D A T E   &   M A I N T A I N   I N D E X */
@@ -682,6 +699,7 @@ ReadPathVecX& ReadPathVecX::operator=(const ReadPathVecX& source){
  * @brief updates the ZipIndex every skip read_ids, updates the next_start_rid 
  */
 void ReadPathVecX::updateZipIndex(){
+    assertInMemory();
     // this will be fast, assuming reserved, or at least initialized
     // store every skip^th read_id, starting from start_rid
     if ((next_start_rid-start_rid)%skip == 0){
@@ -695,6 +713,7 @@ void ReadPathVecX::updateZipIndex(){
  */
 void ReadPathVecX::recompileZipIndex(){
     if(start_rid==next_start_rid) return;
+    assertInMemory();
     ForceAssertGt(next_start_rid,start_rid);
     ZipIndex.reserve(storageSize()/meanPathLength()/skip+10);
     if (ZipIndex.size()==0) ZipIndex.push_back(0);
@@ -719,17 +738,27 @@ ReadPathVecX::~ReadPathVecX(){
 void ReadPathVecX::destroy(){
     start_rid = 0;
     next_start_rid = 0;
-    skip = 10;
+    skip = DEFAULT_SKIP;
     Destroy(ZippedData);
     Destroy(ZipIndex);
+    mapping.reset();
+    mappedData = nullptr;
+    mappedIndex = nullptr;
+    mappedDataSize = 0;
+    mappedIndexSize = 0;
 }
 
 void ReadPathVecX::clear(){
     start_rid = 0;
     next_start_rid = 0;
-    skip = 10;
+    skip = DEFAULT_SKIP;
     ZippedData.clear();
     ZipIndex.clear();
+    mapping.reset();
+    mappedData = nullptr;
+    mappedIndex = nullptr;
+    mappedDataSize = 0;
+    mappedIndexSize = 0;
 }
 
 /* P S E U D O   M O D I F I E R S   &   A C C E S S O R S  F U N C T I O N S */
@@ -740,7 +769,7 @@ void ReadPathVecX::clear(){
  * @return 
  */
 int64_t ReadPathVecX::storageSize() const{
-    return ZippedData.size();
+    return mapping ? mappedDataSize : static_cast<int64_t>(ZippedData.size());
 }
 
 /**
@@ -790,7 +819,9 @@ double ReadPathVecX::meanPathLength() const{
  * @param read_id: const int64_t
  */
 void ReadPathVecX::extractRPX(ReadPathX& rpx, const int64_t read_id){
-    rpx.assign(accessItr(read_id),accessItr(read_id+1));
+    int64_t idx = accessIdx(read_id), next = idx;
+    jumpIdx(next);
+    rpx.assign(uCharArray(zippedData()+idx,zippedData()+next));
 }
 
 /**
@@ -801,7 +832,7 @@ void ReadPathVecX::extractRPX(ReadPathX& rpx, const int64_t read_id){
  * @return 
  */
 unsigned char ReadPathVecX::getNumEdges(const int64_t read_id) const {
-    return LLgetNumEdges(ZippedData,accessIdx(read_id));
+    return LLgetNumEdges(zippedData(),accessIdx(read_id));
 }
 
 /**
@@ -812,7 +843,7 @@ unsigned char ReadPathVecX::getNumEdges(const int64_t read_id) const {
  * @return 
  */
 int ReadPathVecX::getOffset(const int64_t read_id) const { 
-    return LLgetOffset(ZippedData,accessIdx(read_id));
+    return LLgetOffset(zippedData(),accessIdx(read_id));
 }
 
 /**
@@ -845,7 +876,7 @@ void ReadPathVecX::addOffset(const int64_t read_id, int add ) {
  * @return 
  */
 unsigned ReadPathVecX::getFirstSkip(const int64_t read_id) const { 
-    int mOffset = LLgetOffset(ZippedData,accessIdx(read_id));
+    int mOffset = LLgetOffset(zippedData(),accessIdx(read_id));
     return (mOffset < 0 ? 0u : static_cast<unsigned>(mOffset));
 }
 
@@ -860,6 +891,29 @@ void ReadPathVecX::setFirstSkip(const int64_t read_id, unsigned firstSkip ) {
     FatalErr("setFirstSkip is not implemented yet");
 }
 
+/**
+ * @brief returns the number of reads per ZipIndex entry
+ *
+ * @return 
+ */
+int64_t ReadPathVecX::getSkip() const {
+    return skip;
+}
+
+/**
+ * @brief sets the number of reads per ZipIndex entry, rebuilding the index
+ *
+ * @param sk: const int64_t
+ */
+void ReadPathVecX::setSkip(const int64_t sk) {
+    ForceAssertGt(sk,0);
+    if(sk == skip)
+        return;
+    assertInMemory();
+    skip = sk;
+    ZipIndex.clear();
+    recompileZipIndex();
+}
 
 /* S T D   O/P */
 
@@ -876,10 +930,10 @@ ostream& operator<<( ostream& os, const ReadPathVecX& rpvx)
     // std::copy( rpvx.ZippedData.begin(), rpvx.ZippedData.end(), std::ostream_iterator<unsigned int>(os, " ") );
     cout<<"Zipped Data: [";
     for(int64_t i = 0; i<rpvx.storageSize(); i++)
-        cout<<static_cast<int>(rpvx.ZippedData[i])<<",";
+        cout<<static_cast<int>(rpvx.zippedData()[i])<<",";
     cout<<"]"<<endl<<"Zip Index: [";
-    for(uint64_t i = 0; i<rpvx.ZipIndex.size(); i++)
-        cout<<static_cast<int>(rpvx.ZipIndex[i])<<",";
+    for(int64_t i = 0; i<rpvx.zipIndexSize(); i++)
+        cout<<static_cast<int>(rpvx.zipIndex()[i])<<",";
     cout<<"]"<<endl<<"start_rid: "<<rpvx.start_rid<<", next_start_rid: "<<rpvx.next_start_rid<<", skip: "<<rpvx.skip;
     return os;
 }
@@ -892,12 +946,109 @@ ostream& operator<<( ostream& os, const ReadPathVecX& rpvx)
  * @param index: const int64_t, default 0
  */
 void ReadPathVecX::printReadPath(const HyperBasevectorX& hb, const std::string messg, const int64_t index) const{
-    LLprintMe(ZippedData,hb,messg,index);
+    LLprintMe(zippedData(),hb,messg,index);
 }
 
 
 /* R E A D  -  W R I T E */
 
+/**
+ * @brief a read-only memory mapping of a whole file, unmapped when destroyed
+ */
+class ReadPathVecX::Mapping{
+public:
+    explicit Mapping(std::string const& pathname){
+        FileReader fr(pathname);
+        len = fr.getSize();
+        if(len == 0)
+            FatalErr("paths file " << pathname << " is empty");
+        addr = fr.map(0,len,true);
+    }
+
+    ~Mapping(){ munmap(addr,len); }
+
+    Mapping(Mapping const&) = delete;
+    Mapping& operator=(Mapping const&) = delete;
+
+    const unsigned char* bytes() const { return static_cast<const unsigned char*>(addr); }
+    size_t size() const { return len; }
+
+private:
+    void* addr;
+    size_t len;
+};
+
+/**
+ * @brief maps a file written by writeBinary; see the header
+ *
+ * @param pathname: std::string
+ */
+void ReadPathVecX::mapBinary(std::string pathname){
+    clear();
+    if(!IsRegularFile(pathname))
+        FatalErr("readpaths file does not exist");
+    std::shared_ptr<Mapping> map = std::make_shared<Mapping>(pathname);
+
+    // the header is a series of int64_t, the same as readBinary reads
+    size_t pos = 0;
+    auto nextWord = [&](){
+        int64_t word;
+        if(pos+sizeof(word) > map->size())
+            FatalErr("paths file " << pathname << " is truncated");
+        memcpy(&word,map->bytes()+pos,sizeof(word));
+        pos += sizeof(word);
+        return word;
+    };
+    skip = nextWord();
+    start_rid = nextWord();
+    next_start_rid = nextWord();
+    mappedIndexSize = nextWord();
+    mappedDataSize = nextWord();
+    if(pos+sizeof(int64_t)*mappedIndexSize+mappedDataSize != map->size())
+        FatalErr("paths file " << pathname << " has the wrong size");
+
+    // the header is a whole number of words, so the index is aligned
+    mappedIndex = reinterpret_cast<const int64_t*>(map->bytes()+pos);
+    mappedData = map->bytes()+pos+sizeof(int64_t)*mappedIndexSize;
+    mapping = map;
+}
+
+/**
+ * @brief whether this is a mapped file
+ *
+ * @return 
+ */
+bool ReadPathVecX::isMapped() const{
+    return static_cast<bool>(mapping);
+}
+
+/**
+ * @brief the zipped data, in memory or mapped
+ *
+ * @return 
+ */
+const unsigned char* ReadPathVecX::zippedData() const{
+    return mapping ? mappedData : ZippedData.data();
+}
+
+/**
+ * @brief the zip index, in memory or mapped
+ *
+ * @return 
+ */
+const int64_t* ReadPathVecX::zipIndex() const{
+    return mapping ? mappedIndex : ZipIndex.data();
+}
+
+int64_t ReadPathVecX::zipIndexSize() const{
+    return mapping ? mappedIndexSize : static_cast<int64_t>(ZipIndex.size());
+}
+
+void ReadPathVecX::assertInMemory() const{
+    if(mapping)
+        FatalErr("a memory-mapped ReadPathVecX is read-only");
+}
+
 /**
  * @brief read binary: SKIP|STARTRID|NEXTSTARTRID|ZIPINDEX|ZIPPEDDATA
  *
@@ -914,6 +1065,7 @@ void ReadPathVecX::ReadAll(std::string pathname){
 
 void ReadPathVecX::readBinary(std::string pathname){
 
+    clear();
 
     std::ifstream INFILE(pathname, std::ios::in | std::ifstream::binary);
     if(!INFILE.is_open()){
@@ -949,6 +1101,7 @@ void ReadPathVecX::readBinary(std::string pathname){
 
 void ReadPathVecX::readBinary(BinaryReader& reader) {
 
+    clear();
     reader.read(&skip);
     reader.read(&start_rid);
     reader.read(&next_start_rid);
@@ -981,16 +1134,16 @@ void ReadPathVecX::writeBinary(std::string pathname) const{
     OUTFILE.write(reinterpret_cast<const char *>(&skip), sizeof(skip));
     OUTFILE.write(reinterpret_cast<const char *>(&start_rid), sizeof(start_rid));
     OUTFILE.write(reinterpret_cast<const char *>(&next_start_rid), sizeof(next_start_rid));
-    int64_t ziSize = ZipIndex.size();
+    int64_t ziSize = zipIndexSize();
     OUTFILE.write(reinterpret_cast<const char *>(&ziSize), sizeof(ziSize));
-    int64_t zdSize = ZippedData.size();
+    int64_t zdSize = storageSize();
     OUTFILE.write(reinterpret_cast<const char *>(&zdSize), sizeof(zdSize));
 
     // write ZipIndex
-    OUTFILE.write(reinterpret_cast<const char *>(ZipIndex.data()), sizeof(int64_t)*ziSize);
+    OUTFILE.write(reinterpret_cast<const char *>(zipIndex()), sizeof(int64_t)*ziSize);
 
     // write ZippedData
-    OUTFILE.write(reinterpret_cast<const char *>(ZippedData.data()), sizeof(unsigned char)*zdSize);
+    OUTFILE.write(reinterpret_cast<const char *>(zippedData()), sizeof(unsigned char)*zdSize);
     OUTFILE.close();
 
 }
@@ -1000,12 +1153,17 @@ void ReadPathVecX::writeBinary(BinaryWriter& writer) const{
     writer.write(skip);
     writer.write(start_rid);
     writer.write(next_start_rid);
-    int64_t ziSize = ZipIndex.size();
+    int64_t ziSize = zipIndexSize();
     writer.write(ziSize);
-    int64_t zdSize = ZippedData.size();
+    int64_t zdSize = storageSize();
     writer.write(zdSize);
-    writer.write(ZipIndex);
-    writer.write(ZippedData);
+    // as vecs would be written, but from wherever the data is
+    writer.write(static_cast<size_t>(ziSize));
+    if(ziSize)
+        writer.write(zipIndex(),zipIndex()+ziSize);
+    writer.write(static_cast<size_t>(zdSize));
+    if(zdSize)
+        writer.write(zippedData(),zippedData()+zdSize);
 
 }
 
@@ -5,6 +5,7 @@
 
 #include "10X/paths/ReadPathX.h"
 #include "10X/paths/ReadPathParser.h"
+#include <memory>
 
 class ReadPathVecX : private RPParser
 {
@@ -104,6 +105,15 @@ public:
     void unzipAppend(ReadPathVec& paths, const HyperBasevectorX& hb) const;
 
     void parallel_unzipAppend(ReadPathVec& paths, const HyperBasevectorX& hb) const;
+
+    // calls fn(read_id, path) for each read_id in [begin,end), unzipping the
+    // paths in order instead of looking each one up; in parallel, the range is
+    // cut into chunks starting at ZipIndex entries, each of which gets its own
+    // copy of fn (so it can carry workspace), but whatever fn refers to is
+    // shared; chunks hold an even number of reads, so if start_rid is even the
+    // two reads of a pair always go to the same thread
+    template <class Fn>
+    void forEachPath(const HyperBasevectorX& hb, const int64_t begin, const int64_t end, Fn fn, const Bool parallel=True) const;
     
     /* C O P Y   &   A S S I G N M E N T */
 
@@ -148,6 +158,13 @@ public:
 
     void setFirstSkip(const int64_t read_id, unsigned firstSkip);
 
+    // reads per ZipIndex entry: lookups walk skip/2 paths on average, and the
+    // index takes 8/skip bytes per read; changing it rebuilds the index, and
+    // clear() and destroy() set it back to the default
+    int64_t getSkip() const;
+
+    void setSkip(const int64_t sk);
+
 
     /* S T D   O/P */
 
@@ -178,14 +195,41 @@ public:
     void WriteAll(std::string pathname) const;
     void writeBinary(BinaryWriter& writer) const;
 
+    // memory-map a file written by writeBinary, instead of reading it in;
+    // paths are paged in as they're unzipped.  The result is read-only:
+    // anything that would modify it is fatal, until it's cleared, destroyed,
+    // or read. Copies share the mapping.
+    void mapBinary(std::string pathname);
+
+    bool isMapped() const;
+
 private:
 
-    int64_t skip = 10; // determines the size of the zipindex
+    static int64_t const DEFAULT_SKIP = 10;
+    static int64_t const FOREACH_CHUNK = 10000; // reads per forEachPath task
+
+    int64_t skip = DEFAULT_SKIP; // determines the size of the zipindex
     int64_t start_rid; // inclusive
     int64_t next_start_rid; // exclusive
     uCharArray ZippedData;
     vec<int64_t> ZipIndex;
 
+    // set instead of ZippedData and ZipIndex by mapBinary
+    class Mapping;
+    std::shared_ptr<Mapping const> mapping;
+    const unsigned char* mappedData = nullptr;
+    const int64_t* mappedIndex = nullptr;
+    int64_t mappedDataSize = 0;
+    int64_t mappedIndexSize = 0;
+
+    // where the data and index are, either way
+    const unsigned char* zippedData() const;
+    const int64_t* zipIndex() const;
+    int64_t zipIndexSize() const;
+
+    // fatal if mapped
+    void assertInMemory() const;
+
     /* U P D A T E   &   M A I N T A I N   I N D E X */
 
     // updates the ZipIndex every skip read_ids, updates the next_start_rid even if not explicitly included in the index
@@ -211,6 +255,35 @@ private:
 
 SELF_SERIALIZABLE(ReadPathVecX);
 
+template <class Fn>
+void ReadPathVecX::forEachPath(const HyperBasevectorX& hb, const int64_t begin, const int64_t end, Fn fn, const Bool parallel) const{
+    ForceAssertLe(start_rid,begin);
+    ForceAssertLe(begin,end);
+    ForceAssertLe(end,next_start_rid);
+    if(begin==end)
+        return;
+
+    // whole ZipIndex intervals, enough of them to be worth a thread, and an
+    // even number of reads so that pairs are not split between threads
+    int64_t chunk = skip*Max(int64_t(1),FOREACH_CHUNK/skip);
+    if(chunk%2)
+        chunk *= 2;
+    const int64_t first = (begin-start_rid)/chunk, last = (end-1-start_rid)/chunk;
+    #pragma omp parallel for schedule(dynamic,1) if(parallel)
+    for(int64_t c = first; c <= last; c++){
+        int64_t rid = Max(begin,start_rid+c*chunk);
+        const int64_t stop = Min(end,start_rid+(c+1)*chunk);
+        int64_t idx = accessIdx(rid);
+        ReadPath rp;
+        Fn f(fn);
+        for(; rid < stop; rid++){
+            LLunzip(zippedData(),rp,hb,idx);
+            f(rid,static_cast<const ReadPath&>(rp));
+            jumpIdx(idx);
+        }
+    }
+}
+
 inline void Destroy(ReadPathVecX& v)
 { v.destroy(); }
 
@@ -201,7 +201,9 @@ ReadPathX& ReadPathX::operator=(const ReadPathX& source){
  * @param hb: const HyperBasevectorX&
  */
 void ReadPathX::unzip(ReadPath& rp, const HyperBasevectorX& hb)const{
-    LLunzip(ZippedData,rp,hb);
+    if(ZippedData.size()==0)
+        exit(1);
+    LLunzip(ZippedData.data(),rp,hb);
 }
 
 /**
@@ -212,7 +214,9 @@ void ReadPathX::unzip(ReadPath& rp, const HyperBasevectorX& hb)const{
  * @param hb: HyperBasevectorX&
  */
 void ReadPathX::unzip( vec<int>& rp, int& offset, const HyperBasevectorX& hb) const{
-    LLunzip(ZippedData,rp,offset,hb); 
+    if(ZippedData.size()==0)
+        exit(1);
+    LLunzip(ZippedData.data(),rp,offset,hb);
 }
 
 
@@ -234,7 +238,7 @@ ReadPathX::~ReadPathX(){
  * @return 
  */
 int ReadPathX::getOffset()const {
-    return LLgetOffset(ZippedData);
+    return LLgetOffset(ZippedData.data());
 }
 
 /**
@@ -243,7 +247,7 @@ int ReadPathX::getOffset()const {
  * @return 
  */
 int ReadPathX::getFirstEdge()const {
-    return LLgetFirstEdge(ZippedData);
+    return LLgetFirstEdge(ZippedData.data());
 }
 
 /**
@@ -252,7 +256,7 @@ int ReadPathX::getFirstEdge()const {
  * @return 
  */
 int ReadPathX::getNumEdges()const {
-    return LLgetNumEdges(ZippedData);
+    return LLgetNumEdges(ZippedData.data());
 }
 
 /**
@@ -294,7 +298,7 @@ void ReadPathX::printRaw(){
  * @param messg: std::string
  */
 void ReadPathX::printMe(const HyperBasevectorX& hb, std::string messg) const {
-    LLprintMe(ZippedData,hb,messg);
+    LLprintMe(ZippedData.data(),hb,messg);
     return;
 }
 
@@ -84,7 +84,7 @@ void StageTrim( HyperBasevectorX& hb, HyperBasevector& hbv, vec<int>& inv,
      Cleanup( hbv, inv, rpaths );
      // NOTE EXPENSIVE CONVERSION!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
      cout << Date( ) << ": hbv -> hbx" << endl;
-     hb = HyperBasevectorX(hbv);
+     hb.Initialize(hbv);
     
      dels.clear();
 
@@ -148,7 +148,7 @@ void StageTrim( HyperBasevectorX& hb, HyperBasevector& hbv, vec<int>& inv,
           << ", peak = " << PeakMemUsageGBString( ) << endl;
      Cleanup( hbv, inv, rpaths );
      // NOTE EXPENSIVE CONVERSION !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-     hb = HyperBasevectorX(hbv);
+     hb.Initialize(hbv);
      paths.parallel_append(rpaths,hb);
      // IF YOU WANT OLD READPATHS, THIS IS THE EARLIEST YOU CAN GET IT!
      // NEED TO PASS FIN_DIR AS ARGUMENT
@@ -225,7 +225,7 @@ void StageInsertPatch(String const& dir, int const K, HyperBasevector& hbv,
           cout << Date( ) << ": done translating, mem = " << MemUsageGBString() << endl;
      }
      Destroy(to3), Destroy(left3);
-     hbv = hb3;
+     hbv = std::move(hb3);
      hbv.Involution(inv);
 }
 
@@ -236,16 +236,18 @@ void StageFindPatch(String const& dir, int const K, vecbasevector& bases,
           vec<DataSet>& datasets, vec<int32_t>& bc, const int max_width, 
           Bool ONE_GOOD, vec<basevector>& closures, vec<pair<int,int>>& pairs, 
           Bool const CG2, const Bool STACKSTER,
-          const Bool STACKSTER_ALT, const Bool RESCUE )
+          const Bool STACKSTER_ALT, const Bool RESCUE, const int max_pair_reads,
+          const double max_pair_seconds, const Bool pair_stats )
 {
      // Get started.
 
      STAGE(Patch);
      ForceAssertEq( dup.size()*2, bases.size() );
      MEM(patch_start);
-     // NOTE EXPENSIVE CONVERSION!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-     hb = HyperBasevectorX(hbv);
-     MEM(hbv_copy);
+     // hb is already HyperBasevectorX(hbv), either converted or read in.
+     // Check that, which costs far less than converting again.
+     ForceAssertEq( hb.K( ), hbv.K( ) );
+     ForceAssert( hb.SameAs(hbv) );
 
      // Rescue kmers.
      // We are not doing this any more, there's a separate piece of code
@@ -288,27 +290,14 @@ void StageFindPatch(String const& dir, int const K, vecbasevector& bases,
      {    // Block to kill choose
           int64_t nrp = pathsX.size()/2;
           vec<Bool> choose (nrp, False );
-          #pragma omp parallel for schedule (dynamic,1)
-          for ( int64_t id1 = 0; id1 < pathsX.size(); id1+=2 ) {
-               const int64_t pid = id1/2;
-               ReadPath p;
-               pathsX.unzip( p, hb, id1 );
-               for ( auto e : p ) {
-                    if ( in_pairs[e] ) {
-                         choose[pid] = True;
-                         break;
-                    }
-               }
-               if ( choose[pid] ) continue;
-               p.clear();
-               pathsX.unzip( p, hb, id1+1 );
+          pathsX.forEachPath( hb, 0, 2*nrp, [&]( int64_t id, const ReadPath& p ) {
                for ( auto e : p ) {
                     if ( in_pairs[e] ) {
-                         choose[pid] = True;
+                         choose[id/2] = True;
                          break;
                     }
                }
-          }
+          } );
           for ( int64_t pid = 0; pid < nrp; pid++ ) {
                if ( choose[pid] ) {
                     read_ids.push_back( 2*pid );
@@ -331,40 +320,101 @@ void StageFindPatch(String const& dir, int const K, vecbasevector& bases,
      Destroy( eoi );
      MEM(after_destroy_aux_data_structures);
 
-     // Traverse pairs.
+     // Traverse pairs.  Pairs are handed out one at a time, most expensive
+     // first, the cost of a pair being the number of reads on its edges and
+     // their inverses.  Pairs having more than max_pair_reads reads are
+     // skipped.  Stackster and CloseGap share a deadline max_pair_seconds after
+     // the pair starts; a call that reaches it returns no closures, and CloseGap
+     // is not started once it has passed.  Note that this makes the result
+     // depend on timing.  Zero means no limit.
 
      cout << Date( ) << ": start traversing " << ToStringAddCommas( pairs.size( ) )
           << " pairs" << endl;
      double pclock = WallClockTime( );
-     const int batches = 1000;
-     vec< vec<basevector> > closuresi(batches);
      int64_t NP = pairs.size( );
      vec<int> kmers( hb.E( ) );
      #pragma omp parallel for
      for ( int e = 0; e < hb.E( ); e++ )
           kmers[e] = hb.Kmers(e);
-//     auto& quals = quals_om.load_mutable();       // TO-DO: REMOVE ME 
+     vec<int64_t> cost(NP);
+     vec<int> order(NP);
      #pragma omp parallel for
-     for ( int bi = 0; bi < batches; bi++ )
-     {    for ( int pi = bi * NP / batches; pi < (bi+1) * NP / batches; pi++ )
-          {    int e1 = pairs[pi].first, e2 = pairs[pi].second;
-               if ( STACKSTER )
-               {    vec<basevector> edges = { hb.O(e1), hb.O(e2) };
-                    const int VERBOSITY = 0;
-                    vec<basevector> f;
-                    const Bool EXP = False;
-                    vec<int> trim;
-                    Stackster( e1, e2, edges, bases, quals_subset, K, datasets, 
-                         kmers, inv, dup, paths_subset, paths_index_subset, f, trim,
-                         VERBOSITY, STACKSTER_ALT, EXP );
-                    closuresi[bi].append(f);    }
-               Bool verbose = False;
+     for ( int pi = 0; pi < NP; pi++ )
+     {    int e1 = pairs[pi].first, e2 = pairs[pi].second;
+          cost[pi] = paths_index_subset[e1].size( )
+               + paths_index_subset[ inv[e1] ].size( )
+               + paths_index_subset[e2].size( )
+               + paths_index_subset[ inv[e2] ].size( );
+          order[pi] = pi;    }
+     ParallelSort( order, [&]( const int p1, const int p2 )
+          { return cost[p1] > cost[p2] || ( cost[p1] == cost[p2] && p1 < p2 ); } );
+     enum { PAIR_DONE, PAIR_SKIPPED, PAIR_TIMED_OUT };
+     vec< vec<basevector> > closuresp(NP);
+     vec<float> stime( NP, 0 ), ctime( NP, 0 );
+     vec<char> status( NP, PAIR_DONE );
+//     auto& quals = quals_om.load_mutable();       // TO-DO: REMOVE ME 
+     #pragma omp parallel for schedule(dynamic,1)
+     for ( int oi = 0; oi < NP; oi++ )
+     {    const int pi = order[oi];
+          int e1 = pairs[pi].first, e2 = pairs[pi].second;
+          if ( max_pair_reads > 0 && cost[pi] > max_pair_reads )
+          {    status[pi] = PAIR_SKIPPED;
+               continue;    }
+          double clock = WallClockTime( );
+          const double deadline
+               = ( max_pair_seconds > 0 ? clock + max_pair_seconds : 0 );
+          if ( STACKSTER )
+          {    vec<basevector> edges = { hb.O(e1), hb.O(e2) };
+               const int VERBOSITY = 0;
                vec<basevector> f;
-               if ( CG2 ) CloseGap2( hb, inv, bases, quals_subset, paths_subset, paths_index_subset,
-                    e1, e2, f, verbose, pi, max_width );
-               else CloseGap( hb, inv, bases, quals_subset, paths_subset, paths_index_subset,
-                    e1, e2, f, verbose, pi, max_width );
-               {    closuresi[bi].append(f);    }    }    }
+               const Bool EXP = False;
+               vec<int> trim;
+               Stackster( e1, e2, edges, bases, quals_subset, K, datasets, 
+                    kmers, inv, dup, paths_subset, paths_index_subset, f, trim,
+                    VERBOSITY, STACKSTER_ALT, EXP, vec< pair<int64_t,Bool> >( ),
+                    deadline );
+               closuresp[pi].append(f);    }
+          stime[pi] = WallClockTime( ) - clock;
+          if ( deadline > 0 && clock + stime[pi] > deadline )
+          {    status[pi] = PAIR_TIMED_OUT;
+               continue;    }
+          clock = WallClockTime( );
+          Bool verbose = False;
+          vec<basevector> f;
+          if ( CG2 ) CloseGap2( hb, inv, bases, quals_subset, paths_subset, paths_index_subset,
+               e1, e2, f, verbose, pi, max_width, deadline );
+          else CloseGap( hb, inv, bases, quals_subset, paths_subset, paths_index_subset,
+               e1, e2, f, verbose, pi, max_width, deadline );
+          closuresp[pi].append(f);
+          ctime[pi] = WallClockTime( ) - clock;
+          if ( deadline > 0 && clock + ctime[pi] > deadline )
+               status[pi] = PAIR_TIMED_OUT;    }
+     int64_t skipped = 0, timed_out = 0;
+     for ( int pi = 0; pi < NP; pi++ )
+     {    if ( status[pi] == PAIR_SKIPPED ) skipped++;
+          if ( status[pi] == PAIR_TIMED_OUT ) timed_out++;    }
+     if ( skipped > 0 || timed_out > 0 )
+     {    cout << Date( ) << ": skipped " << ToStringAddCommas(skipped)
+               << " pairs having too many reads, stopped "
+               << ToStringAddCommas(timed_out) << " pairs out of time" << endl;    }
+     if ( NP > 0 )
+     {    int slowest = 0;
+          for ( int pi = 1; pi < NP; pi++ )
+          {    if ( stime[pi] + ctime[pi] > stime[slowest] + ctime[slowest] )
+                    slowest = pi;    }
+          cout << Date( ) << ": slowest pair took " << stime[slowest] + ctime[slowest]
+               << " seconds, reads = " << cost[slowest] << endl;    }
+     if (pair_stats)
+     {    Ofstream( out, dir + "/a.patch_stats" );
+          out << "#pi e1 e2 reads stackster_secs closegap_secs closures status\n";
+          const char* names[ ] = { "done", "skipped", "timed_out" };
+          for ( int pi = 0; pi < NP; pi++ )
+          {    out << pi << " " << pairs[pi].first << " " << pairs[pi].second
+                    << " " << cost[pi] << " " << stime[pi] << " " << ctime[pi]
+                    << " " << closuresp[pi].size( ) << " "
+                    << names[ int( status[pi] ) ] << "\n";    }    }
+     Destroy(cost), Destroy(order), Destroy(stime), Destroy(ctime);
+     Destroy(status);
 
      MEM(traverse_pairs);
      Destroy(paths_index_subset);
@@ -378,8 +428,8 @@ void StageFindPatch(String const& dir, int const K, vecbasevector& bases,
      Destroy(bases);
      MEM(destroyed_bases);
 
-     for ( int bi = 0; bi < batches; bi++ )
-          closures.append( closuresi[bi] );
+     for ( int pi = 0; pi < NP; pi++ )
+          closures.append( closuresp[pi] );
      cout << Date( ) << ": found " << closures.size( ) << " closures" << endl;
      cout << TimeSince(pclock) << " used closing pairs" << endl;
      // cout << Date( ) << ": sorting closures" << endl;
@@ -391,25 +441,27 @@ void StageFindPatch(String const& dir, int const K, vecbasevector& bases,
 
 void StageBuildGraph( String const& MSPEDGES, int const K, vecbasevector& bases, ObjectManager<VecPQVec>& quals_om,
           int MIN_QUAL, int MIN_FREQ, int MIN_BC, vec<int32_t> const& bc, int64_t bc_start,
-          std::string const GRAPH, double const GRAPHMEM,
-          String const& work_dir, String const& read_head, HyperBasevector& hbv, ReadPathVec& paths, vec<int>& inv)
+          std::string const GRAPH, double const GRAPHMEM, String const& GRAPHSPILL,
+          unsigned const PATHING_PREFETCH_DEPTH,
+          String const& work_dir, String const& read_head, HyperBasevector& hbv, ReadPathVecX& pathsX,
+          String const& paths_file, vec<int>& inv)
 {
      STAGE(BuildGraph);
 
      cout << Date() << ": barcoded *datatypes* start at " << bc_start << endl;
 
      MEM(before_graph_creation);
-     if ( K != 48 ) FatalErr("remember that we have changes for K=48 not propagated to other K values.");
-
      if (MSPEDGES=="") {
-          buildReadQGraph48(work_dir, read_head, GRAPH, bases, quals_om, False, False, MIN_QUAL, MIN_FREQ, bc_start, MIN_BC, &bc,
-                              .75, 0, "", True, False, &hbv, &paths, GRAPHMEM, False );
+          buildReadQGraph(K, work_dir, read_head, GRAPH, bases, quals_om, False, False, MIN_QUAL, MIN_FREQ, bc_start, MIN_BC, &bc,
+                              .75, 0, "", True, False, &hbv, &pathsX, paths_file, GRAPHMEM, False, GRAPHSPILL,
+                              PATHING_PREFETCH_DEPTH );
      } else {
           Destroy(bases);
           MEM(after_destroy_bases);
           quals_om.unload();
           MEM(after_quals_unload);
-          buildGraphFromMSP( work_dir, work_dir+read_head+".fastb", quals_om.filename(), MSPEDGES, hbv, K, paths );
+          buildGraphFromMSP( work_dir, work_dir+read_head+".fastb", quals_om.filename(), MSPEDGES, hbv, K, pathsX, paths_file,
+                    PATHING_PREFETCH_DEPTH );
      }
 
      cout << Date( ) << ": back from buildReadQGraph" << endl;
@@ -16,7 +16,7 @@
 #include "math/Functions.h"
 #include "paths/HyperBasevector.h"
 #include "paths/UnibaseUtils.h"
-#include "paths/long/BuildReadQGraph48.h"
+#include "paths/long/BuildReadQGraph.h"
 #include "paths/long/ReadPath.h"
 #include "paths/long/SupportedHyperBasevector.h"
 #include "paths/long/large/Repath.h"
@@ -63,15 +63,18 @@ void StageFindPatch(String const& dir, int const K, vecbasevector& bases, Object
           vec<Bool>& bad, vec<DataSet>& datasets,
           vec<int32_t>& bc, const int max_width, Bool ONE_GOOD, vec<basevector>& closures,
           vec<pair<int,int>>& pairs, Bool const CG2, const Bool STACKSTER,
-          const Bool STACKSTER_ALT, const Bool RESCUE );
+          const Bool STACKSTER_ALT, const Bool RESCUE, const int max_pair_reads = 0,
+          const double max_pair_seconds = 0, const Bool pair_stats = False );
 
 void StageInsertPatch(String const& dir, int const K, HyperBasevector& hbv, 
           vec<int>& inv, ReadPathVecX& pathsX, vec<basevector>& closures);
 
 void StageBuildGraph( String const& MSPEDGES, int const K, vecbasevector& bases, ObjectManager<VecPQVec>& quals_om,
           int MIN_QUAL, int MIN_FREQ, int MIN_BC, vec<int32_t> const& bc, int64_t bc_start,
-          std::string const GRAPH, double const GRAPHMEM,
-          String const& work_dir, String const& read_head, HyperBasevector& hbv, ReadPathVec& paths, vec<int>& inv);
+          std::string const GRAPH, double const GRAPHMEM, String const& GRAPHSPILL,
+          unsigned const PATHING_PREFETCH_DEPTH,
+          String const& work_dir, String const& read_head, HyperBasevector& hbv, ReadPathVecX& pathsX,
+          String const& paths_file, vec<int>& inv);
 
 void StageEBC( HyperBasevectorX& hb, vec<int>& inv, VecULongVec& paths_index,
                vec<int32_t>& bc, vec<vec<int>>& ebc, VecIntVec& ebcx );
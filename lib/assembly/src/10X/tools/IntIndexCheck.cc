@@ -0,0 +1,59 @@
+// Copyright (c) 2016 10X Genomics, Inc. All rights reserved.
+
+// IntIndexCheck.  IntIndex splits the reads into batches, as many as there are
+// threads but capped by the number of keys, and scatters each batch into its
+// own slots.  Check the result against a plain serial transpose of the paths,
+// for thread counts that do and don't divide the reads evenly, and for shapes
+// on both sides of the cap: many keys with few reads each, and few keys with
+// many.  Some reads have empty paths and some visit a key twice.
+
+// MakeDepend: cflags OMP_FLAGS
+
+#include <omp.h>
+
+#include "MainTools.h"
+#include "10X/IntIndex.h"
+#include "paths/long/ReadPath.h"
+#include "random/Random.h"
+
+int main(int argc, char *argv[])
+{
+     RunTime( );
+
+     BeginCommandArguments;
+     CommandArgument_UnsignedInt_OrDefault_Doc(N, 200000,
+          "number of reads");
+     EndCommandArguments;
+
+     vec< pair<int64_t,int> > shapes = { { N, N/2 }, { N, 7 }, { 1000, 50000 },
+          { 5, 3 }, { 0, 10 } };
+     for ( auto shape : shapes )
+     {    const int64_t nreads = shape.first;
+          const int NE = shape.second;
+          ReadPathVec paths(nreads);
+          vec<vec<int64_t>> expect(NE);
+          for ( int64_t id = 0; id < nreads; id++ )
+          {    const int n = randomx( ) % 4;
+               for ( int j = 0; j < n; j++ )
+               {    const int e = ( j > 0 && randomx( ) % 20 == 0
+                         ? paths[id][0] : randomx( ) % NE );
+                    paths[id].push_back(e);
+                    expect[e].push_back(id);    }    }
+          for ( int threads : { 1, 3, 8, 64 } )
+          {    omp_set_num_threads(threads);
+               IntIndex ind( paths, NE );
+               ForceAssertEq( ind.N( ), NE );
+               for ( int e = 0; e < NE; e++ )
+               {    if ( ind.Count(e) != expect[e].isize( ) )
+                    {    FatalErr( threads << " threads, " << nreads << " reads, "
+                              << NE << " keys: key " << e << " has "
+                              << ind.Count(e) << " values, expected "
+                              << expect[e].size( ) );    }
+                    for ( int i = 0; i < expect[e].isize( ); i++ )
+                    {    if ( ind.Val( e, i ) != expect[e][i] )
+                         {    FatalErr( threads << " threads, " << nreads
+                                   << " reads, " << NE << " keys: value " << i
+                                   << " of key " << e << " is " << ind.Val( e, i )
+                                   << ", expected " << expect[e][i] );    }    }    }    }
+          cout << nreads << " reads, " << NE << " keys: index matches" << endl;    }
+}
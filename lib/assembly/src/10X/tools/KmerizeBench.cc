@@ -0,0 +1,155 @@
+// Copyright (c) 2016 10X Genomics, Inc. All rights reserved.
+
+// KmerizeBench.  Time the kmerization that the graph builders do, at K=40, 48
+// and 60: canonical kmers with their contexts, and a hash of each.  Compares
+// the old way (KMer::toSuccessor, isRev, a reverse-complemented copy, and the
+// byte-wise KMer::Hasher) with RollingKmerizer, which also computes the word
+// hash.  Also times the two hash functions alone.  Checks that the two
+// kmerizers agree.
+
+#include "MainTools.h"
+#include "Basevector.h"
+#include "kmers/KMer.h"
+#include "kmers/KMerContext.h"
+#include "kmers/RollingKmerizer.h"
+#include "random/Random.h"
+
+namespace
+{
+
+void SimulateReads( size_t N, int len, vecbvec& reads )
+{    reads.reserve(N);
+     bvec b(len);
+     for ( size_t id = 0; id < N; id++ )
+     {    for ( int i = 0; i < len; i++ )
+               b.set( i, randomx( ) % 4 );
+          reads.push_back(b);    }    }
+
+// The kmerization loop from the graph builders' Kmerizers, plus the hash that
+// the MapReduceEngine takes of each kmer.
+template <unsigned K, class Proc>
+void OldKmerize( bvec const& read, Proc proc )
+{    typedef KMer<K> Kmer;
+     if ( read.size( ) < K+1 ) return;
+     auto beg = read.begin( ), itr = beg + K, last = beg + ( read.size( ) - 1 );
+     typename Kmer::Hasher hasher;
+     Kmer kkk(beg);
+     KMerContext kc = KMerContext::initialContext(*itr);
+     auto emit = [&]( )
+     {    if ( kkk.isRev( ) )
+          {    Kmer krc(kkk);
+               krc.rc( );
+               proc( krc, kc.rc( ), hasher(krc) );    }
+          else proc( kkk, kc, hasher(kkk) );    };
+     emit( );
+     while ( itr != last )
+     {    unsigned char pred = kkk.front( );
+          kkk.toSuccessor(*itr); ++itr;
+          kc = KMerContext(pred,*itr);
+          emit( );    }
+     kc = KMerContext::finalContext( kkk.front( ) );
+     kkk.toSuccessor(*last);
+     emit( );    }
+
+template <unsigned K>
+void Bench( vecbvec const& reads, unsigned reps )
+{    typedef KMer<K> Kmer;
+     cout << "\nK=" << K << endl;
+     size_t nkmers = 0;
+     for ( auto const& read : reads )
+          if ( read.size( ) > K ) nkmers += read.size( ) - K + 1;
+     auto report = [&]( String const& name, double secs, uint64_t cksum )
+     {    cout << name << ": " << nkmers * reps / secs / 1e6
+               << " M kmers/s, checksum " << cksum << endl;    };
+
+     // Check that the two kmerizers agree on kmers and contexts, and that the
+     // rolling kmerizer's hashes are word hashes.
+
+     RollingKmerizer<K> rk;
+     vec<Kmer> kmers;
+     vec<KMerContext> contexts;
+     for ( auto const& read : reads )
+     {    kmers.clear( ), contexts.clear( );
+          OldKmerize<K>( read, [&]( Kmer const& kmer, KMerContext kc, size_t )
+               { kmers.push_back(kmer), contexts.push_back(kc); } );
+          rk.clear( );
+          if ( read.size( ) > K ) rk.kmerize( read.begin( ), read.end( ) );
+          if ( rk.size( ) != kmers.size( ) )
+               FatalErr( "The kmerizers found different numbers of kmers." );
+          size_t i = 0;
+          for ( auto const& item : rk )
+          {    if ( item.mKmer != kmers[i] || item.mContext != contexts[i] )
+                    FatalErr( "The kmerizers disagree." );
+               if ( item.mHash != item.mKmer.wordHash( ) )
+                    FatalErr( "The rolling kmerizer's hash is wrong." );
+               i++;    }    }
+     cout << "kmerizers agree" << endl;
+
+     {    uint64_t cksum = 0;
+          double clock = WallClockTime( );
+          for ( unsigned rep = 0; rep < reps; rep++ )
+          for ( auto const& read : reads )
+          {    OldKmerize<K>( read,
+                    [&]( Kmer const& kmer, KMerContext kc, size_t hash )
+                    { cksum += hash; } );    }
+          report( "old kmerizer", WallClockTime( ) - clock, cksum );    }
+     {    uint64_t cksum = 0;
+          double clock = WallClockTime( );
+          for ( unsigned rep = 0; rep < reps; rep++ )
+          for ( auto const& read : reads )
+          {    rk.clear( );
+               if ( read.size( ) > K ) rk.kmerize( read.begin( ), read.end( ) );
+               for ( auto const& item : rk )
+                    cksum += item.mHash;    }
+          report( "rolling kmerizer", WallClockTime( ) - clock, cksum );    }
+
+     // The hash functions alone.
+
+     kmers.clear( );
+     for ( auto const& read : reads )
+     {    rk.clear( );
+          if ( read.size( ) > K ) rk.kmerize( read.begin( ), read.end( ) );
+          for ( auto const& item : rk )
+               kmers.push_back(item.mKmer);    }
+     {    typename Kmer::Hasher hasher;
+          uint64_t cksum = 0;
+          double clock = WallClockTime( );
+          for ( unsigned rep = 0; rep < reps; rep++ )
+          for ( auto const& kmer : kmers )
+               cksum += hasher(kmer);
+          report( "KMer::Hasher", WallClockTime( ) - clock, cksum );    }
+     {    typename Kmer::WordHasher hasher;
+          uint64_t cksum = 0;
+          double clock = WallClockTime( );
+          for ( unsigned rep = 0; rep < reps; rep++ )
+          for ( auto const& kmer : kmers )
+               cksum += hasher(kmer);
+          report( "KMer::WordHasher", WallClockTime( ) - clock, cksum );    }    }
+
+}
+
+int main(int argc, char *argv[])
+{
+     RunTime( );
+
+     BeginCommandArguments;
+     CommandArgument_String_OrDefault_Doc(READS, "",
+          "fastb of reads to kmerize; if empty, simulate some");
+     CommandArgument_UnsignedInt_OrDefault_Doc(N, 500000,
+          "number of reads to simulate");
+     CommandArgument_Int_OrDefault_Doc(LEN, 150, "length of simulated reads");
+     CommandArgument_UnsignedInt_OrDefault_Doc(REPS, 3,
+          "number of times to kmerize everything");
+     EndCommandArguments;
+
+     vecbvec reads;
+     if ( READS != "" ) reads.ReadAll(READS);
+     else SimulateReads( N, LEN, reads );
+     cout << "kmerizing " << ToStringAddCommas( reads.size( ) ) << " reads, "
+          << REPS << " times" << endl;
+
+     Bench<40>( reads, REPS );
+     Bench<48>( reads, REPS );
+     Bench<60>( reads, REPS );
+     return 0;
+}
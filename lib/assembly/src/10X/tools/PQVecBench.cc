@@ -0,0 +1,131 @@
+// Copyright (c) 2016 10X Genomics, Inc. All rights reserved.
+
+// PQVecBench.  Time the PQVec decoders against one another: the original serial
+// decoder and the block decoder (BMI2 if available), and reading quals from a
+// VirtualMasterVec one at a time and with PQVecBatch.  Uses the quals in QUALP
+// if given, otherwise N simulated reads.  Checks that all the results agree.
+
+#include "MainTools.h"
+#include "Qualvector.h"
+#include "feudal/PQVec.h"
+#include "feudal/PQVecBatch.h"
+#include "feudal/VirtualMasterVec.h"
+#include "random/Random.h"
+#include "system/System.h"
+
+namespace
+{
+
+// Illumina-like quals: mostly high, binned, with runs of low quals toward the
+// end of some reads.
+void SimulateQuals( size_t N, int len, VecPQVec& quals )
+{    vec<int> const bins = { 2, 7, 14, 21, 27, 32, 36, 41 };
+     qvec q(len);
+     quals.reserve(N);
+     for ( size_t id = 0; id < N; id++ )
+     {    int bad_from = ( randomx( ) % 4 == 0 ? randomx( ) % len : len );
+          for ( int i = 0; i < len; i++ )
+          {    int bin = ( i >= bad_from ? randomx( ) % 3
+                    : 4 + randomx( ) % 4 );
+               q[i] = bins[bin];    }
+          quals.push_back( PQVec(q) );    }    }
+
+}
+
+int main(int argc, char *argv[])
+{
+     RunTime( );
+
+     BeginCommandArguments;
+     CommandArgument_String_OrDefault_Doc(QUALP, "",
+          "quals to decode; if empty, simulate some");
+     CommandArgument_UnsignedInt_OrDefault_Doc(N, 2000000,
+          "number of reads to simulate");
+     CommandArgument_Int_OrDefault_Doc(LEN, 150, "length of simulated reads");
+     CommandArgument_UnsignedInt_OrDefault_Doc(REPS, 5,
+          "number of times to decode everything");
+     CommandArgument_UnsignedInt_OrDefault_Doc(BATCH, 10000,
+          "number of reads per PQVecBatch");
+     EndCommandArguments;
+
+     String qualp = QUALP;
+     if ( qualp == "" )
+     {    qualp = "/tmp/PQVecBench." + ToString( getpid( ) ) + ".qualp";
+          VecPQVec sim;
+          SimulateQuals( N, LEN, sim );
+          sim.WriteAll(qualp);    }
+     VirtualMasterVec<PQVec> vquals(qualp);
+     std::vector<char> raw;
+     std::vector<size_t> offs;
+     vquals.loadRaw( 0, vquals.size( ), &raw, &offs );
+     raw.resize( raw.size( ) + 8 ); // decodeSerial reads whole words
+     auto packed = [&]( size_t id )
+     {    return reinterpret_cast<PQVecEncoder::byte const*>( &raw[ offs[id] ] ); };
+     size_t nquals = 0;
+     for ( size_t id = 0; id < vquals.size( ); id++ )
+          if ( offs[id] != offs[id+1] )
+               nquals += PQVecEncoder::decodedSize( packed(id) );
+     cout << "decoding " << ToStringAddCommas( vquals.size( ) ) << " reads, "
+          << ToStringAddCommas(nquals) << " quals, " << REPS << " times" << endl;
+     cout << "BMI2 is " << ( PQVecEncoder::usingBMI2( ) ? "" : "not " )
+          << "in use" << endl;
+
+     // Decode everything in each of four ways, checksumming the output.
+
+     auto report = [&]( String const& name, double secs, uint64_t cksum )
+     {    cout << name << ": " << secs / REPS << " s/pass, "
+               << nquals * REPS / secs / 1e6 << " M quals/s, checksum "
+               << cksum << endl;    };
+     auto sum = []( uint8_t const* q, size_t n, uint64_t& cksum )
+     {    for ( size_t i = 0; i < n; i++ )
+               cksum += q[i] * ( i + 1 );    };
+
+     // The decoders proper, on packed data that's already in memory.
+
+     vec<uint64_t> cksums;
+     for ( int pass = 0; pass < 2; pass++ )
+     {    vec<uint8_t> q;
+          uint64_t cksum = 0;
+          double clock = WallClockTime( );
+          for ( unsigned rep = 0; rep < REPS; rep++ )
+          for ( size_t id = 0; id < vquals.size( ); id++ )
+          {    if ( offs[id] == offs[id+1] ) continue;
+               q.resize( PQVecEncoder::decodedSize( packed(id) ) );
+               if ( pass == 0 ) PQVecEncoder::decodeSerial( packed(id), q.data( ) );
+               else PQVecEncoder::decode( packed(id), q.data( ) );
+               sum( q.data( ), q.size( ), cksum );    }
+          report( pass == 0 ? "serial decoder" : "block decoder",
+               WallClockTime( ) - clock, cksum );
+          cksums.push_back(cksum);    }
+     std::vector<char>( ).swap(raw), std::vector<size_t>( ).swap(offs);
+
+     // Reading from disk: one element at a time, as VirtualMasterVec users
+     // have always done, and then a batch at a time.
+
+     {    qvec q;
+          uint64_t cksum = 0;
+          double clock = WallClockTime( );
+          for ( unsigned rep = 0; rep < REPS; rep++ )
+          for ( size_t id = 0; id < vquals.size( ); id++ )
+          {    vquals[id].unpack(&q);
+               if ( q.size( ) ) sum( &q[0], q.size( ), cksum );    }
+          report( "VirtualMasterVec", WallClockTime( ) - clock, cksum );
+          cksums.push_back(cksum);    }
+     {    PQVecBatch batch;
+          uint64_t cksum = 0;
+          double clock = WallClockTime( );
+          for ( unsigned rep = 0; rep < REPS; rep++ )
+          for ( size_t start = 0; start < vquals.size( ); start += BATCH )
+          {    batch.unpack( vquals, start,
+                    Min( start + BATCH, (size_t) vquals.size( ) ) );
+               for ( size_t j = 0; j < batch.size( ); j++ )
+                    sum( batch.begin(j), batch.eleSize(j), cksum );    }
+          report( "PQVecBatch", WallClockTime( ) - clock, cksum );
+          cksums.push_back(cksum);    }
+
+     if ( QUALP == "" ) Remove(qualp);
+     for ( auto cksum : cksums )
+          if ( cksum != cksums[0] ) FatalErr( "The decoders disagree." );
+     cout << "decoders agree" << endl;
+     return 0;
+}
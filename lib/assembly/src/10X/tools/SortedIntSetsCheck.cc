@@ -0,0 +1,100 @@
+// Copyright (c) 2016 10X Genomics, Inc. All rights reserved.
+
+// SortedIntSetsCheck.  Check SortedMeetSize and SortedIntersection against
+// MeetSize and Intersection where the kernels are most likely to go wrong:
+//
+// 1. Every pair of subsets of [0,8).  This covers all tail lengths left over
+//    after the four-at-a-time merge, and every pattern of matches within a
+//    block, including blocks whose last elements tie.
+// 2. A run against a shifted copy of itself, so that matches land in every
+//    rotation of the SSE2 compare.
+// 3. Sets holding INT_MIN and INT_MAX, which would show up any comparison done
+//    by subtraction.
+// 4. Size ratios either side of the switch to galloping, with the small set's
+//    elements before, at and past both ends of the big one.
+
+#include <climits>
+
+#include "MainTools.h"
+#include "VecUtilities.h"
+#include "10X/SortedIntSets.h"
+
+namespace
+{
+
+void Check( const vec<int>& a, const vec<int>& b )
+{    const int64_t m = MeetSize( a, b );
+     vec<int> want, c;
+     Intersection( a, b, want );
+     for ( int pass = 0; pass < 2; pass++ )
+     {    const vec<int>& x = ( pass == 0 ? a : b );
+          const vec<int>& y = ( pass == 0 ? b : a );
+          SortedIntersection( x, y, c );
+          if ( SortedMeetSize( x, y ) != m || c != want )
+          {    cout << "first set:";
+               for ( auto v : x ) cout << " " << v;
+               cout << "\nsecond set:";
+               for ( auto v : y ) cout << " " << v;
+               cout << "\nexpected intersection:";
+               for ( auto v : want ) cout << " " << v;
+               cout << "\ngot:";
+               for ( auto v : c ) cout << " " << v;
+               FatalErr( "\nSortedMeetSize gives " << SortedMeetSize( x, y )
+                    << ", expected " << m );    }    }    }
+
+}
+
+int main(int argc, char *argv[])
+{
+     RunTime( );
+
+     BeginCommandArguments;
+     EndCommandArguments;
+
+     vec<int> a, b;
+
+     for ( int s = 0; s < 256; s++ )
+     for ( int t = 0; t < 256; t++ )
+     {    a.clear( ), b.clear( );
+          for ( int j = 0; j < 8; j++ )
+          {    if ( s & ( 1 << j ) ) a.push_back(j);
+               if ( t & ( 1 << j ) ) b.push_back(j);    }
+          Check( a, b );    }
+
+     for ( int n : { 4, 7, 8, 9, 64, 67 } )
+     for ( int shift = -9; shift <= 9; shift++ )
+     {    a.clear( ), b.clear( );
+          for ( int j = 0; j < n; j++ )
+          {    a.push_back( 3*j );
+               b.push_back( 3*j + 3*shift );    }
+          Check( a, b );    }
+
+     a = { INT_MIN, INT_MIN + 1, -1, 0, 1, INT_MAX - 1, INT_MAX };
+     for ( int s = 0; s < 128; s++ )
+     {    b.clear( );
+          for ( int j = 0; j < a.isize( ); j++ )
+               if ( s & ( 1 << j ) ) b.push_back( a[j] );
+          Check( a, b );
+          b.push_back( INT_MAX ), UniqueSort(b);
+          Check( a, b );    }
+
+     // b holds the even numbers from 10 to last, ratio times as many as a has.
+     // Odd elements of a fall between elements of b, and 0 falls before it.
+
+     for ( int ratio : { 31, 32, 33 } )
+     for ( int pick = 0; pick < 7; pick++ )
+     {    const int na = ( pick < 4 ? 1 : pick - 2 );
+          b.clear( );
+          for ( int j = 0; j < ratio * na; j++ )
+               b.push_back( 10 + 2*j );
+          const int last = b.back( );
+          switch (pick)
+          {    case 0: a = { 0 }; break;
+               case 1: a = { 10 }; break;
+               case 2: a = { last }; break;
+               case 3: a = { last + 1 }; break;
+               case 4: a = { 11, last }; break;
+               case 5: a = { 0, last / 2, last + 2 }; break;
+               default: a = { 10, 11, last - 1, last };    }
+          Check( a, b );    }
+}
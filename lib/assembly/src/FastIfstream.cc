@@ -154,7 +154,7 @@ Bool get_to( fast_ifstream& in, String& s, const String& tail )
           FatalErr( "get_to called on failed fast_ifstream for " 
                << in.fr_.getFilename() << "." );
 
-     static vec<char> linebuf;
+     thread_local vec<char> linebuf;
      linebuf.resize(0);
      int nt = tail.size( ), ls;
 
@@ -243,7 +243,7 @@ void getline( fast_pipe_ifstream& in, String& s )
 
      // The slow case.
 
-     static avector<char> linebuf(0);
+     thread_local avector<char> linebuf(0);
      char* x = linebuf.x;
      char* top = linebuf.x + linebuf.length;
      const int buf_incr = 100;
@@ -290,7 +290,7 @@ Bool getline_if_match( fast_pipe_ifstream& in, String& s, const String& begin )
 
      // The slow case.
 
-     static avector<char> linebuf(0);
+     thread_local avector<char> linebuf(0);
      char* x = linebuf.x;
      char* top = linebuf.x + linebuf.length;
      const int buf_incr = 100;
@@ -337,7 +337,7 @@ Bool get_to( fast_pipe_ifstream& in, String& s, const String& tail )
           FatalErr( "get_to called on failed fast_pipe_ifstream for " 
                << in.command_ << "." );
 
-     static vec<char> linebuf;
+     thread_local vec<char> linebuf;
      linebuf.resize(0);
      int nt = tail.size( ), ls;
 
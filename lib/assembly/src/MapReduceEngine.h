@@ -23,13 +23,18 @@
 #include "system/SysConf.h"
 #include "system/System.h"
 #include "system/Thread.h"
+#include "system/file/FileReader.h"
+#include "system/file/FileWriter.h"
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <cstdlib>
 #include <functional>
+#include <iterator>
 #include <memory>
 #include <mutex>
 #include <omp.h>
+#include <string>
 #include <thread>
 #include <vector>
 #include <utility>
@@ -92,12 +97,47 @@
 //    vecbvec reads(READS);
 //    mre.process(reads.getKmerCount(K),reads.cbegin(),reads.cend(),true);
 //
+// Each thread claims chunks of the input as it's ready for more work, and
+// sorts the keys it maps into a batch for each thread.  Then each thread
+// merges the batches meant for it directly out of the other threads' buffers,
+// and reduces them.  So the threads wait for one another just twice per pass.
+// With verbosity, the engine reports how long the threads spent mapping,
+// shuffling (sorting their batches), and reducing.
+//
+// If the keys won't fit into memory all at once, the engine normally maps the
+// entire input once for each of several passes, keeping only a slice of the
+// keys each time.  If you give it a spill directory (on local disk, ideally)
+// it can instead map the input just once, hash-partitioning the keys into
+// bucket files, and then read and reduce the buckets one at a time.  The
+// number of buckets is chosen so that each thread can sort and reduce one
+// bucket in its share of the memory budget.  Spilling requires that Keys can
+// be written to disk and read back as raw bytes.
+//
+// If the Impl can get the hashes of its keys cheaply while mapping, it can
+// write HashedKeys to the output iterator, and save the engine hashing them.
+//
+
+// A key, along with the value that the engine's Hash would return for it.
+template <class Key>
+struct HashedKey
+{
+    HashedKey( Key const& key, size_t hash ) : mKey(key), mHash(hash) {}
+    operator Key const&() const { return mKey; }
+
+    Key const& mKey;
+    size_t mHash;
+};
+
 template <class Impl, class Key, class Hash, class Comp=std::less<Key>>
 class MapReduceEngine
 {
     struct KeyBounds
     { Key* mpStart; Key* mpCur; Key* mpEnd; };
 
+    // a sorted run of keys that's waiting to be reduced
+    struct Run
+    { Key* mpCur; Key* mpEnd; };
+
     class KeyBuf
     {
     public:
@@ -157,42 +197,22 @@ class MapReduceEngine
           new (kb.mpCur++) Key(key);
           return true; }
 
-        size_t getMaxBatchSize()
-        { size_t result = 0;
-          for ( KeyBounds* itr=mBounds; itr != mEnd; ++itr )
-              result = std::max(result,size_t(itr->mpCur-itr->mpStart));
-          return result; }
-
-        void move( KeyBounds& from, size_t batch )
-        { KeyBounds& to = mBounds[batch];
-          ForceAssertEq(to.mpStart,to.mpCur);
-          Key* end = from.mpCur;
-          for ( Key* itr = from.mpStart; itr != end; ++itr )
-          { new (to.mpCur++) Key(std::move(*itr)); itr->~Key(); }
-          from.mpCur = from.mpStart; }
-
-        Key* begin() const { return mBounds->mpStart; }
-        Key* compress()
-        { KeyBounds* itr = mBounds;
-          Key* beg = itr->mpStart;
-          Key* end = itr->mpCur;
-          itr->mpCur = itr->mpStart;
-          KeyBounds* last = mEnd-1;
-          ForceAssertEq(last->mpStart,last->mpCur);
-          while ( ++itr != last )
-          { if ( itr->mpStart == end )
-            { end = itr->mpCur; itr->mpCur = itr->mpStart; continue; }
-            for ( Key* pKey=itr->mpStart; pKey != itr->mpCur; ++pKey )
-            { new (end++) Key(std::move(*pKey)); pKey->~Key(); }
-            itr->mpCur = itr->mpStart; }
-          return end; }
+        // destroy the keys in all the batches
+        void clear()
+        { for ( KeyBounds* itr=mBounds; itr != mEnd; ++itr )
+            while ( itr->mpCur != itr->mpStart )
+              (--itr->mpCur)->~Key(); }
 
     private:
         KeyBounds* mBounds;
         KeyBounds* mEnd;
     };
 
-    enum class Cycle { INIT, MAP, SWIZZLE, REDUCE, EXIT };
+    enum class Cycle { INIT, MAP, REDUCE, EXIT };
+
+    // wall-clock seconds that a client thread spent in each phase
+    struct PhaseTimes
+    { double mMap = 0.; double mShuffle = 0.; double mReduce = 0.; };
 
     class Status
     {
@@ -200,8 +220,8 @@ class MapReduceEngine
         Status( size_t nThreads, size_t nPasses, size_t nKeysPerBatch )
         : mNThreads(nThreads), mNPasses(nPasses), mNKeysPerBatch(nKeysPerBatch),
           mNTotalBatches(mNThreads*mNPasses), mPass(0), mOK(true),
-          mpKeyBufs(new KeyBuf*[nThreads]), mDoneCount(0),
-          mCycle(Cycle::INIT), mSwizDone(0), mSwizGen(0), mNOverflows(0)
+          mpKeyBufs(new KeyBuf*[nThreads]), mTimes(nThreads), mDoneCount(0),
+          mCycle(Cycle::INIT), mNextInput(0), mNOverflows(0)
         {}
 
         ~Status()
@@ -219,12 +239,18 @@ class MapReduceEngine
         void incrementNOverflows() { mNOverflows += 1; }
 
         size_t getPass() const { return mPass; }
-        void setPass( size_t pass ) { mPass = pass; }
+        void setPass( size_t pass ) { mPass = pass; mNextInput = 0; }
+
+        // claim the next chunk of inputs to map during this pass
+        size_t claimInputs( size_t chunkSize )
+        { return mNextInput.fetch_add(chunkSize); }
 
         KeyBuf& getKeyBuf( size_t thread ) { return *mpKeyBufs[thread]; }
         void setKeyBuf( size_t thread, KeyBuf* pKeyBuf )
         { mpKeyBufs[thread] = pKeyBuf; }
 
+        PhaseTimes& getTimes( size_t thread ) { return mTimes[thread]; }
+
         void fail() { mOK = false; }
         bool OK() const { return mOK; }
 
@@ -245,14 +271,6 @@ class MapReduceEngine
               mCycleCV.wait(lock);
           return mCycle == Cycle::MAP; }
 
-        // wait until it's time to do a swizzle cycle
-        bool waitForSwizzle()
-        { done();
-          std::unique_lock<std::mutex> lock(mCycleMtx);
-          while ( mCycle != Cycle::SWIZZLE && mCycle != Cycle::EXIT )
-              mCycleCV.wait(lock);
-          return mCycle == Cycle::SWIZZLE; }
-
         // wait until it's time to do a reduce cycle
         bool waitForReduce()
         { done();
@@ -261,16 +279,6 @@ class MapReduceEngine
               mCycleCV.wait(lock);
           return mCycle == Cycle::REDUCE; }
 
-        // thread barrier -- wait until everyone is done with the current
-        // round of swizzling
-        void swizDone()
-        { std::unique_lock<std::mutex> lock(mSwizMtx);
-          size_t swizGen = mSwizGen;
-          if ( ++mSwizDone == mNThreads )
-          { mSwizGen += 1; mSwizDone = 0; mSwizCV.notify_all(); }
-          while ( swizGen == mSwizGen )
-              mSwizCV.wait(lock); }
-
     private:
         void done()
         { std::unique_lock<std::mutex> lock(mDoneMtx);
@@ -289,16 +297,14 @@ class MapReduceEngine
         size_t mPass;
         bool mOK;
         KeyBuf** mpKeyBufs;
+        std::vector<PhaseTimes> mTimes;
         std::mutex mDoneMtx;
         std::condition_variable mDoneCV;
         size_t mDoneCount;
         std::mutex mCycleMtx;
         std::condition_variable mCycleCV;
         Cycle mCycle;
-        std::mutex mSwizMtx;
-        std::condition_variable mSwizCV;
-        size_t mSwizDone;
-        size_t mSwizGen;
+        std::atomic_size_t mNextInput;
         std::atomic_size_t mNOverflows;
     };
 
@@ -313,7 +319,14 @@ class MapReduceEngine
         OItr& operator++(int) { return *this; }
 
         Key const& operator=( Key const& key )
-        { size_t batch = mMRE.mHasher(key)%mStatus.getNTotalBatches();
+        { return add(key,mMRE.mHasher(key)); }
+
+        Key const& operator=( HashedKey<Key> const& hashedKey )
+        { return add(hashedKey.mKey,hashedKey.mHash); }
+
+    private:
+        Key const& add( Key const& key, size_t hash )
+        { size_t batch = hash%mStatus.getNTotalBatches();
           size_t nThreads = mStatus.getNThreads();
           if ( batch/nThreads == mStatus.getPass() )
           { size_t bin = batch%nThreads;
@@ -325,68 +338,79 @@ class MapReduceEngine
                 mStatus.fail(); } }
           return key; }
 
-    private:
         MapReduceEngine& mMRE;
         Status& mStatus;
         KeyBuf* mpKeyBuf;
     };
 
+    // A client thread claims chunks of input from a shared counter, and maps
+    // them into its KeyBuf, which has a batch of keys for each thread.  At the
+    // end of the map cycle it sorts each of its batches.  In the reduce cycle
+    // it merges the sorted batches that all the threads have made for it,
+    // reading them in place, and reduces each run of equal keys.
     template <class Itr>
     class Client
     {
     public:
         Client( size_t thread, MapReduceEngine& mre, Status& status,
                     Itr beg, Itr end )
-        : mThread(thread), mMRE(mre), mStatus(status)
-        { size_t nTotInputs = end - beg;
-          size_t nThreads = mStatus.getNThreads();
-          size_t nInputsPerThread = (nTotInputs+nThreads-1)/nThreads;
-          mBeg = beg+std::min(nTotInputs,mThread*nInputsPerThread);
-          mEnd = beg+std::min(nTotInputs,(mThread+1)*nInputsPerThread); }
+        : mThread(thread), mMRE(mre), mStatus(status), mBeg(beg),
+          mNInputs(end-beg)
+        { size_t const CHUNKS_PER_THREAD = 64;
+          mChunkSize = std::max(1ul,
+                        mNInputs/mStatus.getNThreads()/CHUNKS_PER_THREAD); }
 
         void operator()()
         {
             size_t nThreads = mStatus.getNThreads();
-            KeyBuf kb(nThreads+1,mStatus.getNKeysPerBatch());
-            size_t nSwizzles = (nThreads - 1)/2;
+            KeyBuf kb(nThreads,mStatus.getNKeysPerBatch());
             mStatus.setKeyBuf(mThread,&kb);
+            PhaseTimes& times = mStatus.getTimes(mThread);
+            std::vector<Run> runs;
+            runs.reserve(nThreads);
+            std::vector<Key> group;
 
             while ( mStatus.waitForMap() )
             {
+                // everyone is done reducing last pass's keys
+                kb.clear();
+                double clock = WallClockTime();
+
                 // this must be inside loop because it reads the pass #.
                 OItr oItr(mMRE,mStatus,&kb);
 
-                for ( Itr itr = mBeg; mStatus.OK() && itr != mEnd; ++itr )
-                    mMRE.mImpl.map(itr,oItr);
-
-                if ( !mStatus.waitForSwizzle() )
-                    break;
-                for ( size_t swizzle = 0; swizzle != nSwizzles; ++swizzle )
+                size_t first;
+                while ( mStatus.OK() &&
+                        (first = mStatus.claimInputs(mChunkSize)) < mNInputs )
                 {
-                    size_t batch = (mThread+swizzle+1) % nThreads;
-                    kb.move( kb.getBounds(batch), nThreads );
-                    kb.move( mStatus.getKeyBuf(batch).getBounds(mThread), batch );
-                    mStatus.swizDone();
-
-                    batch = (mThread+nThreads-swizzle-1) % nThreads;
-                    KeyBuf& kb2 = mStatus.getKeyBuf(batch);
-                    kb.move( kb2.getBounds(nThreads), batch );
-                    mStatus.swizDone();
+                    Itr itr = mBeg+first;
+                    Itr last = mBeg+std::min(mNInputs,first+mChunkSize);
+                    for ( ; itr != last; ++itr )
+                        mMRE.mImpl.map(itr,oItr);
                 }
-                if ( !(nThreads & 1) )
-                {
-                    size_t batch = (mThread+nSwizzles+1) % nThreads;
-                    kb.move( kb.getBounds(batch), nThreads );
-                    mStatus.swizDone();
+                double clock2 = WallClockTime();
+                times.mMap += clock2 - clock;
 
-                    KeyBuf& kb2 = mStatus.getKeyBuf(batch);
-                    kb.move( kb2.getBounds(nThreads), batch );
-                    mStatus.swizDone();
+                for ( size_t batch = 0; batch != nThreads; ++batch )
+                {
+                    KeyBounds& bounds = kb.getBounds(batch);
+                    std::sort(bounds.mpStart,bounds.mpCur,mMRE.mComparator);
                 }
+                times.mShuffle += WallClockTime() - clock2;
 
                 if ( !mStatus.waitForReduce() )
                     break;
-                mMRE.reduce(kb.begin(),kb.compress());
+                clock = WallClockTime();
+                runs.clear();
+                for ( size_t thread = 0; thread != nThreads; ++thread )
+                {
+                    KeyBounds& bounds =
+                            mStatus.getKeyBuf(thread).getBounds(mThread);
+                    if ( bounds.mpCur != bounds.mpStart )
+                        runs.push_back(Run{bounds.mpStart,bounds.mpCur});
+                }
+                mMRE.mergeReduce(runs,group);
+                times.mReduce += WallClockTime() - clock;
             }
         }
 
@@ -395,14 +419,16 @@ class MapReduceEngine
         MapReduceEngine mMRE;
         Status& mStatus;
         Itr mBeg;
-        Itr mEnd;
+        size_t mNInputs;
+        size_t mChunkSize;
     };
 
 public:
     MapReduceEngine( Impl const& impl=Impl(),
                         Hash const& hasher=Hash(),
                         Comp const& comparator=Comp() )
-    : mImpl(impl), mHasher(hasher), mComparator(comparator), mFailed(false)
+    : mImpl(impl), mHasher(hasher), mComparator(comparator), mFailed(false),
+      mMaxInMemoryPasses(MAX_PASSES)
     {}
 
     ~MapReduceEngine()
@@ -410,6 +436,13 @@ public:
 
     enum class VERBOSITY { SILENT, QUIET, NOISY };
 
+    static size_t const MAX_PASSES = 500;
+
+    // Spill keys to temporary files in dir rather than making more than
+    // maxInMemoryPasses passes over the input.
+    void setSpillDir( std::string const& dir, size_t maxInMemoryPasses = 1 )
+    { mSpillDir = dir; mMaxInMemoryPasses = maxInMemoryPasses; }
+
     // nKs must be an upper bound on the number of Ks produced by mapping the
     // entire input set.  We assume that largish subsets of the input are
     // linearish in their production of Ks.
@@ -449,7 +482,7 @@ public:
 
         size_t const nThreads = getConfiguredNumThreads();
 
-        size_t maxKs = meanHashUsage*nThreads/(nThreads+1)*maxMem/sizeof(Key);
+        size_t maxKs = meanHashUsage*maxMem/sizeof(Key);
         if ( !maxKs ) {
             PRINT4(nThreads,maxMem,maxKs,meanHashUsage);
             Martian::exit("Insufficient memory.");
@@ -458,7 +491,16 @@ public:
         size_t nPasses = (nKs+maxKs-1)/maxKs;
         if ( nPasses == 0 )
             FatalErr("No work to do. The calling code should watch for this case");
-        size_t const MAX_PASSES = 500;
+        if ( !mSpillDir.empty() && nPasses > mMaxInMemoryPasses )
+        {
+            if ( verbose != VERBOSITY::SILENT )
+                std::cout << Date( ) << ": MapReduce would need " << nPasses
+                          << " passes, so spilling keys to " << mSpillDir
+                          << std::endl;
+            runSpilling(nKs,beg,end,maxMem,nThreads,verbose);
+            omp_set_num_threads(getConfiguredNumThreads());
+            return true;
+        }
         if ( nPasses > MAX_PASSES )
         {   cout << "\nWell this is unfortunate.  It seems that there is "
                  << "unsufficient memory.\n"
@@ -474,7 +516,7 @@ public:
 
         size_t meanKsPerBatch = nKs/nPasses/nThreads/nThreads;
         size_t nKsPerBatch = meanKsPerBatch/meanHashUsage;
-        size_t memUsed = nKsPerBatch*nThreads*(nThreads+1)*sizeof(Key);
+        size_t memUsed = nKsPerBatch*nThreads*nThreads*sizeof(Key);
         nKsPerBatch = nKsPerBatch*std::min(1.*maxMem/memUsed,2.);
         size_t const MIN_BATCH_SIZE = 100000;
         if ( nKsPerBatch < MIN_BATCH_SIZE )
@@ -501,19 +543,6 @@ public:
                 if ( pass ) std::cout << ".\n";
                 std::cout<<Date()<<" Pass "<<pass+1<<" parse,"<< std::flush;
             }
-            if ( !status.setCycle(Cycle::SWIZZLE) )
-                break;
-            if ( verbose == VERBOSITY::NOISY )
-            {
-#if 0
-                size_t maxBatchSz = 0;
-                for ( size_t thread = 0; thread != nThreads; ++thread )
-                    maxBatchSz = std::max(maxBatchSz,
-                                    status.getKeyBuf(thread).getMaxBatchSize());
-                std::cout << ' ' << 1.*maxBatchSz/nKsPerBatch;
-#endif
-                std::cout << " swizzle," << std::flush;
-            }
             if ( !status.setCycle(Cycle::REDUCE) )
                 break;
             if ( verbose == VERBOSITY::NOISY )
@@ -539,6 +568,7 @@ public:
             if ( nOverflows )
                 std::cout << "There were " << nOverflows
                             << " buffer overflows." << std::endl;
+            reportTimes(status,verbose);
         }
 
         omp_set_num_threads(getConfiguredNumThreads());
@@ -547,6 +577,177 @@ public:
     }
 
 private:
+    // Spill mode.  Each thread maps inputs into a buffer for each bucket, and
+    // appends a full buffer to the bucket's file.  Then each thread reads,
+    // sorts and reduces whole buckets.
+    template <class Itr>
+    void runSpilling( size_t nKs, Itr beg, Itr end, size_t maxMem,
+                        size_t nThreads, VERBOSITY verbose )
+    {
+        double clock = WallClockTime();
+        size_t const SPILL_BUCKET_FILL = 2; // allow for uneven buckets
+        size_t bucketKeys = std::max(1ul,maxMem/nThreads/SPILL_BUCKET_FILL/sizeof(Key));
+        size_t nBuckets = std::max(nThreads,(nKs+bucketKeys-1)/bucketKeys);
+        size_t const MAX_SPILL_BUF = 8ul << 20;
+        size_t bufKeys = maxMem/2/nThreads/nBuckets;
+        bufKeys = std::max(1ul,std::min(bufKeys,MAX_SPILL_BUF)/sizeof(Key));
+        if ( verbose != VERBOSITY::SILENT )
+            std::cout << Date( ) << ": spilling about "
+                      << ToStringAddCommas(nKs*sizeof(Key)) << " bytes into "
+                      << nBuckets << " buckets" << std::endl;
+
+        Mkdir777(mSpillDir);
+        std::string spillHead = mSpillDir + "/mre." + ToString(getpid()) + ".";
+        auto bucketFile = [&spillHead]( size_t bucket )
+        { return spillHead + ToString(bucket); };
+        for ( size_t bucket = 0; bucket != nBuckets; ++bucket )
+            FileWriter(bucketFile(bucket));
+        std::vector<std::mutex> bucketLocks(nBuckets);
+
+        // map
+        size_t const MAP_BATCH = 1000;
+        std::atomic_size_t nextInput(0);
+        size_t nInputs = end - beg;
+        std::vector<std::thread> threads;
+        for ( size_t thread = 0; thread != nThreads; ++thread )
+            threads.emplace_back([&,this]()
+            { MapReduceEngine mre(*this);
+              SpillBufs bufs(mre.mHasher,nBuckets,bufKeys,
+                  [&]( size_t bucket, Key const* keys, size_t nKeys )
+                  { std::lock_guard<std::mutex> lock(bucketLocks[bucket]);
+                    FileWriter(bucketFile(bucket),true)
+                        .write(keys,nKeys*sizeof(Key)); });
+              SpillOItr oItr(bufs);
+              size_t first;
+              while ( (first = nextInput.fetch_add(MAP_BATCH)) < nInputs )
+              { Itr itr = beg+first;
+                Itr last = beg+std::min(nInputs,first+MAP_BATCH);
+                for ( ; itr != last; ++itr )
+                    mre.mImpl.map(itr,oItr); } });
+        for ( auto& thread : threads ) thread.join();
+        threads.clear();
+        if ( verbose != VERBOSITY::SILENT )
+            std::cout << Date( ) << ": spilled keys in "
+                      << TimeSince(clock) << std::endl;
+
+        // reduce
+        clock = WallClockTime();
+        std::atomic_size_t nextBucket(0);
+        for ( size_t thread = 0; thread != nThreads; ++thread )
+            threads.emplace_back([&,this]()
+            { MapReduceEngine mre(*this);
+              std::allocator<Key> alloc;
+              Key* keys = nullptr;
+              size_t capacity = 0;
+              size_t bucket;
+              while ( (bucket = nextBucket++) < nBuckets )
+              { std::string fileName = bucketFile(bucket);
+                FileReader fr(fileName.c_str());
+                size_t nKeys = fr.getSize()/sizeof(Key);
+                if ( nKeys > capacity )
+                { if ( keys ) alloc.deallocate(keys,capacity);
+                  keys = alloc.allocate(capacity = nKeys); }
+                if ( nKeys ) fr.read(keys,nKeys*sizeof(Key));
+                fr.close();
+                Remove(fileName);
+                mre.reduce(keys,keys+nKeys); }
+              if ( keys ) alloc.deallocate(keys,capacity); });
+        for ( auto& thread : threads ) thread.join();
+        if ( verbose != VERBOSITY::SILENT )
+            std::cout << Date( ) << ": reduced buckets in "
+                      << TimeSince(clock) << std::endl;
+    }
+
+    // Per-thread buffers for the map phase of spill mode.
+    class SpillBufs
+    {
+    public:
+        typedef std::function<void(size_t,Key const*,size_t)> Spill;
+
+        SpillBufs( Hash const& hasher, size_t nBuckets, size_t bufKeys,
+                    Spill const& spill )
+        : mHasher(hasher), mBufKeys(bufKeys), mSpill(spill),
+          mKeys(std::allocator<Key>().allocate(nBuckets*bufKeys)),
+          mCounts(nBuckets,0)
+        {}
+
+        SpillBufs( SpillBufs const& ) = delete;
+        SpillBufs& operator=( SpillBufs const& ) = delete;
+
+        ~SpillBufs()
+        { flush();
+          std::allocator<Key>().deallocate(mKeys,mCounts.size()*mBufKeys); }
+
+        void add( Key const& key )
+        { add(key,mHasher(key)); }
+
+        void add( Key const& key, size_t hash )
+        { size_t bucket = hash % mCounts.size();
+          size_t& count = mCounts[bucket];
+          new (mKeys+bucket*mBufKeys+count) Key(key);
+          if ( ++count == mBufKeys ) spill(bucket); }
+
+        void flush()
+        { for ( size_t bucket = 0; bucket != mCounts.size(); ++bucket )
+            if ( mCounts[bucket] ) spill(bucket); }
+
+    private:
+        void spill( size_t bucket )
+        { Key* keys = mKeys+bucket*mBufKeys;
+          size_t& count = mCounts[bucket];
+          mSpill(bucket,keys,count);
+          while ( count ) keys[--count].~Key(); }
+
+        Hash mHasher;
+        size_t mBufKeys;
+        Spill mSpill;
+        Key* mKeys;
+        std::vector<size_t> mCounts;
+    };
+
+    class SpillOItr
+    {
+    public:
+        SpillOItr( SpillBufs& bufs ) : mBufs(bufs) {}
+
+        SpillOItr& operator*() { return *this; }
+        SpillOItr& operator++() { return *this; }
+        SpillOItr& operator++(int) { return *this; }
+
+        Key const& operator=( Key const& key )
+        { mBufs.add(key); return key; }
+
+        Key const& operator=( HashedKey<Key> const& hashedKey )
+        { mBufs.add(hashedKey.mKey,hashedKey.mHash); return hashedKey.mKey; }
+
+    private:
+        SpillBufs& mBufs;
+    };
+
+    // Print the time the client threads spent in each phase:  the worst and
+    // the mean, and, if we're being noisy, each thread's.
+    void reportTimes( Status& status, VERBOSITY verbose )
+    { size_t nThreads = status.getNThreads();
+      PhaseTimes maxTimes, totTimes;
+      for ( size_t thread = 0; thread != nThreads; ++thread )
+      { PhaseTimes const& times = status.getTimes(thread);
+        if ( verbose == VERBOSITY::NOISY )
+          std::cout << "thread " << thread << ": map " << times.mMap
+                    << " s, shuffle " << times.mShuffle
+                    << " s, reduce " << times.mReduce << " s" << std::endl;
+        maxTimes.mMap = std::max(maxTimes.mMap,times.mMap);
+        maxTimes.mShuffle = std::max(maxTimes.mShuffle,times.mShuffle);
+        maxTimes.mReduce = std::max(maxTimes.mReduce,times.mReduce);
+        totTimes.mMap += times.mMap;
+        totTimes.mShuffle += times.mShuffle;
+        totTimes.mReduce += times.mReduce; }
+      std::cout << "MapReduce seconds per thread (max/mean): map "
+                << maxTimes.mMap << '/' << totTimes.mMap/nThreads
+                << ", shuffle " << maxTimes.mShuffle << '/'
+                << totTimes.mShuffle/nThreads
+                << ", reduce " << maxTimes.mReduce << '/'
+                << totTimes.mReduce/nThreads << std::endl; }
+
     template <class Itr>
     void runSingleThreaded( size_t nKs, Itr itr, Itr end )
     { std::vector<Key> keys;
@@ -583,6 +784,49 @@ private:
         itr = itr2; }
       while ( end != beg ) (--end)->~Key(); }
 
+    // end of the run of keys equal to *beg
+    Key* groupEnd( Key* beg, Key* end )
+    { Key* itr = beg;
+      while ( ++itr != end )
+        if ( mComparator(*beg,*itr) )
+          break;
+      return itr; }
+
+    // Merge some sorted runs of keys, and reduce each group of equal keys.
+    // Usually a group comes from just one run, and is reduced in place.
+    // Otherwise its keys are moved into the group vector, and reduced there.
+    // The keys are left to be destroyed by the runs' owner.
+    void mergeReduce( std::vector<Run>& runs, std::vector<Key>& group )
+    { auto later = [this]( Run const& run1, Run const& run2 )
+                    { return mComparator(*run2.mpCur,*run1.mpCur); };
+      std::make_heap(runs.begin(),runs.end(),later);
+      while ( !runs.empty() )
+      { std::pop_heap(runs.begin(),runs.end(),later);
+        Run run = runs.back();
+        runs.pop_back();
+        Key* grpEnd = groupEnd(run.mpCur,run.mpEnd);
+        if ( runs.empty() || mComparator(*run.mpCur,*runs.front().mpCur) )
+          mImpl.reduce(run.mpCur,grpEnd);
+        else
+        { group.assign(std::make_move_iterator(run.mpCur),
+                        std::make_move_iterator(grpEnd));
+          while ( !runs.empty() &&
+                  !mComparator(group.front(),*runs.front().mpCur) )
+          { std::pop_heap(runs.begin(),runs.end(),later);
+            Run& other = runs.back();
+            Key* otherEnd = groupEnd(other.mpCur,other.mpEnd);
+            group.insert(group.end(),std::make_move_iterator(other.mpCur),
+                            std::make_move_iterator(otherEnd));
+            if ( (other.mpCur = otherEnd) == other.mpEnd )
+              runs.pop_back();
+            else
+              std::push_heap(runs.begin(),runs.end(),later); }
+          mImpl.reduce(group.data(),group.data()+group.size()); }
+        if ( (run.mpCur = grpEnd) != run.mpEnd )
+        { runs.push_back(run);
+          std::push_heap(runs.begin(),runs.end(),later); } }
+      group.clear(); }
+
     static Key* moveKeys( Key* itr, Key* end, Key* oItr )
     { if ( itr == oItr ) return end;
       while ( itr != end ) *oItr++ = std::move(*itr++);
@@ -592,6 +836,8 @@ private:
     Hash mHasher;
     Comp mComparator;
     bool mFailed;
+    std::string mSpillDir;
+    size_t mMaxInMemoryPasses;
 };
 
 
@@ -63,6 +63,15 @@ public:
       { mReader.seek(mpMapper->getOffset(ele)); mCurEle = ele+1; }
       return mReader; }
 
+    /// Get a BinaryReader positioned so that it's ready to read the variable-
+    /// length data for elements [begin,end) in one go.  The caller must read
+    /// all of it.
+    BinaryReader& getDataRange( size_t begin, size_t end )
+    { AssertLe(begin,end); AssertLe(end,getNElements());
+      if ( begin != mCurEle ) mReader.seek(mpMapper->getOffset(begin));
+      mCurEle = end;
+      return mReader; }
+
     /// Get a pointer to the fixed-length data for the specified element
     void* getFixedData( size_t ele, size_t bytesPerEle ) const
     { return mpMapper->getFixedData(ele,bytesPerEle); }
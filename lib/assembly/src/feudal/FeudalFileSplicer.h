@@ -0,0 +1,83 @@
+// Copyright (c) 2016 10X Genomics, Inc. All rights reserved.
+
+/*
+ * \file FeudalFileSplicer.h
+ *
+ * \brief Concatenate ranges of elements from several feudal files into a new
+ * feudal file without deserializing any of the elements.
+ *
+ * A feudal file is a control block, followed by the variable-length data, a
+ * table of (absolute) offsets into the variable-length data, and the
+ * fixed-length data.  Splicing element ranges therefore only requires bulk
+ * copies of the variable-length and fixed-length data, plus a rebasing of the
+ * offsets.  Each range is copied directly into its final position in the
+ * output, so the ranges are copied in parallel.
+ */
+#ifndef FEUDAL_FEUDALFILESPLICER_H_
+#define FEUDAL_FEUDALFILESPLICER_H_
+
+#include "system/SysConf.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class FeudalFileSplicer
+{
+public:
+    /// The last three args are as for FeudalFileWriter.
+    FeudalFileSplicer( std::string const& filename, size_t vecSize,
+                        size_t eltSize, size_t fixedLenDataLen )
+    : mFilename(filename), mVecSize(vecSize), mEltSize(eltSize),
+      mFixedLenDataLen(fixedLenDataLen), mNElements(0), mVarDataLen(0) {}
+
+    FeudalFileSplicer( FeudalFileSplicer const& )=delete;
+    FeudalFileSplicer& operator=( FeudalFileSplicer const& )=delete;
+
+    /// Append elements [begin,end) of the feudal file srcFile.
+    void add( std::string const& srcFile, size_t begin, size_t end );
+
+    /// Append all the elements of the feudal file srcFile.
+    void add( std::string const& srcFile );
+
+    /// Number of elements appended so far.
+    size_t getNElements() const { return mNElements; }
+
+    /// Write the output file.
+    void write( size_t nThreads = getConfiguredNumThreads() );
+
+private:
+    struct Piece
+    {
+        std::string mFile;
+        size_t mBegin;      // first element in source
+        size_t mEnd;        // one past the last element in source
+        size_t mVarOffset;  // source file offset of first byte of var data
+        size_t mVarLen;     // bytes of var data
+        size_t mOutEle;     // index of first element in output
+        size_t mOutVarOff;  // offset of var data within output's var data
+    };
+
+    void copyPiece( Piece const& piece, size_t outVarTabOffset,
+                        size_t outFixedOffset ) const;
+
+    std::string mFilename;
+    size_t mVecSize;
+    size_t mEltSize;
+    size_t mFixedLenDataLen;
+    size_t mNElements;
+    size_t mVarDataLen;
+    std::vector<Piece> mPieces;
+};
+
+/// A FeudalFileSplicer for feudal files of T.
+template <class T>
+class TypedFeudalFileSplicer : public FeudalFileSplicer
+{
+public:
+    template <class C>
+    explicit TypedFeudalFileSplicer( C const& filename )
+    : FeudalFileSplicer(filename,sizeof(T),sizeof(typename T::value_type),
+                        T::fixedDataLen()) {}
+};
+
+#endif /* FEUDAL_FEUDALFILESPLICER_H_ */
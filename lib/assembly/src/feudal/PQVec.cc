@@ -14,6 +14,11 @@
 
 #include "feudal/PQVec.h"
 #include "math/PowerOf2.h"
+#include <cstring>
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define PQVEC_BMI2 1
+#endif
 
 void PQVecEncoder::init( qvec const& qv )
 {
@@ -126,7 +131,7 @@ PQVecEncoder::byte* PQVecEncoder::encode( byte* pBuf ) const
     return pBuf;
 }
 
-void PQVecEncoder::decode( byte const* pqBuf, byte* pQs )
+void PQVecEncoder::decodeSerial( byte const* pqBuf, byte* pQs )
 {
     uint64_t addr = reinterpret_cast<uint64_t>(pqBuf);
     uint64_t* buf = reinterpret_cast<uint64_t*>(addr&~7);
@@ -187,5 +192,141 @@ void PQVecEncoder::decode( byte const* pqBuf, byte* pQs )
     }
 }
 
+namespace
+{
+
+#ifdef PQVEC_BMI2
+// Each block is a byte giving the number of quals, 3 bits giving the number of
+// bits per qual, 6 bits giving the minimum qual, and then the packed quals
+// (less the minimum), starting at bit 17 of the block.  Eight quals at a time:
+// load the (at most 56) bits that hold them, and deposit each qual into its own
+// byte with pdep.  Quals never exceed 63, so adding the minimum to all eight
+// bytes at once can't carry from one byte into the next.
+unsigned const FIRST_Q_BIT = 17;
+uint64_t const ONES = 0x0101010101010101ul;
+
+__attribute__((target("bmi2")))
+void decodeBlockBMI2( unsigned char const* blk, unsigned blkLen, unsigned nQs,
+                        unsigned nBits, unsigned char minQ, unsigned char* pQs )
+{
+    uint64_t const spread = ((1ul << nBits) - 1ul) * ONES;
+    uint64_t const min = minQ * ONES;
+    unsigned bit = FIRST_Q_BIT;
+    for ( unsigned idx = 0; idx < nQs; idx += 8, bit += 8*nBits )
+    {
+        unsigned from = bit >> 3;
+        uint64_t word = 0;
+        if ( from + 8 <= blkLen )
+            memcpy(&word,blk+from,8);
+        else
+            memcpy(&word,blk+from,blkLen-from);
+        uint64_t qs = _pdep_u64(word >> (bit&7),spread) + min;
+        if ( nQs - idx >= 8 )
+            memcpy(pQs+idx,&qs,8);
+        else
+            memcpy(pQs+idx,&qs,nQs-idx);
+    }
+}
+
+bool haveBMI2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2");
+}
+
+bool const gUseBMI2 = haveBMI2();
+#else
+bool const gUseBMI2 = false;
+#endif
+
+}
+
+void PQVecEncoder::decode( byte const* pqBuf, byte* pQs )
+{
+#ifdef PQVEC_BMI2
+    if ( gUseBMI2 )
+    {
+        unsigned nQs;
+        while ( (nQs = *pqBuf) )
+        {
+            unsigned nBits = pqBuf[1] & 7;
+            byte minQ = (pqBuf[1] >> 3) | ((pqBuf[2] & 1) << 5);
+            unsigned blkLen = Block::blockSize(nQs,nBits);
+            if ( !nBits )
+                memset(pQs,minQ,nQs);
+            else
+                decodeBlockBMI2(pqBuf,blkLen,nQs,nBits,minQ,pQs);
+            pqBuf += blkLen;
+            pQs += nQs;
+        }
+        return;
+    }
+#endif
+    decodeSerial(pqBuf,pQs);
+}
+
+bool PQVecEncoder::usingBMI2() { return gUseBMI2; }
+
+uint64_t PQVecEncoder::sum( byte const* pqBuf )
+{
+    uint64_t result = 0;
+    uint64_t addr = reinterpret_cast<uint64_t>(pqBuf);
+    uint64_t* buf = reinterpret_cast<uint64_t*>(addr&~7);
+    uint64_t bits = *buf++;
+    addr = (addr & 7) << 3;
+    uint64_t remain = 64 - addr;
+    bits >>= addr;
+    uint64_t nQs;
+    while ( (nQs = bits&0xff) )
+    {
+        bits >>= 8;
+        if ( !(remain -= 8) )
+        {
+            bits = *buf++;
+            remain = 64;
+        }
+        uint64_t nBits = bits & 0x07;
+        bits >>= 3;
+        uint64_t minQ = bits & 0x3f;
+        bits >>= 6;
+        if ( remain < 9 )
+        {
+            bits = *buf++;
+            minQ |= (bits & 1) << 5;
+            bits >>= 1;
+            remain += 64;
+        }
+        remain -= 9;
+        result += nQs*minQ;
+        if ( nBits )
+        {
+            uint64_t mask = (1ul<<nBits)-1ul;
+            while ( nQs-- )
+            {
+                uint64_t val = bits;
+                uint64_t used = nBits;
+                if ( remain < nBits )
+                {
+                    bits = *buf++;
+                    val |= bits << remain;
+                    used -= remain;
+                    remain += 64;
+                }
+                remain -= nBits;
+                bits >>= used;
+                result += val & mask;
+            }
+        }
+        bits >>= remain & 7;
+        remain &= ~7ul;
+        if ( !remain )
+        {
+            bits = *buf++;
+            remain = 64;
+        }
+    }
+    return result;
+}
+
 #include "feudal/OuterVecDefs.h"
 template class OuterVec<PQVec>;
@@ -48,8 +48,26 @@ public:
 
     byte* encode( byte* pBuf ) const;
 
+    // unpacks a block at a time, and eight quals at a time if the processor
+    // has BMI2
     static void decode( byte const* pqBuf, byte* pQs );
 
+    // the original decoder, one qual at a time.  decode must match it.
+    static void decodeSerial( byte const* pqBuf, byte* pQs );
+
+    // number of quals in an encoded buffer
+    static size_t decodedSize( byte const* pqBuf )
+    { size_t nQs, result = 0;
+      while ( (nQs = *pqBuf++) )
+      { result += nQs; pqBuf += Block::blockSize(nQs,*pqBuf&7)-1; }
+      return result; }
+
+    // whether decode is using the BMI2 code
+    static bool usingBMI2();
+
+    // sum of the quals in an encoded buffer, without unpacking them
+    static uint64_t sum( byte const* pqBuf );
+
 private:
     struct Block
     { Block( byte nQs, byte bits, byte minQ )
@@ -90,8 +108,16 @@ public:
       pQV->resize(nQs);
       PQVecEncoder::decode(data(),&pQV->front()); }
 
+    // unpack into a buffer with room for vSize() quals
+    void unpack( byte* pQs ) const
+    { byte const* buf = data(); if ( buf ) PQVecEncoder::decode(buf,pQs); }
+
     operator qvec() const { qvec qv; unpack(&qv); return qv; }
 
+    // sum of the quals -- same as summing an unpacked qvec
+    uint64_t qualSum() const
+    { byte const* buf = data(); return buf ? PQVecEncoder::sum(buf) : 0; }
+
     // all the rest of this crap is boilerplate
     PQVecA() { new (&allocator()) Alloc; }
 
@@ -128,11 +154,8 @@ public:
 
     // number of bytes in original, uncompressed representation
     size_type vSize() const
-    { byte const* buf = data(); if ( !buf ) return 0;
-      size_t nQs, result = 0;
-      while ( (nQs = *buf++) )
-      { result += nQs; buf += PQVecEncoder::Block::blockSize(nQs,*buf&7)-1; }
-      return result; }
+    { byte const* buf = data();
+      return buf ? PQVecEncoder::decodedSize(buf) : 0; }
 
     PQVecA& clear()
     { byte* buf = data(); if ( buf ) allocator().deallocate(buf,size());
@@ -0,0 +1,86 @@
+// Copyright (c) 2016 10X Genomics, Inc. All rights reserved.
+
+/*
+ * \file PQVecBatch.h
+ *
+ * \brief Unpack a run of PQVecs into one reusable buffer.
+ *
+ * Unpacking PQVecs one at a time into a qvec costs an allocation per element
+ * when they come from a VirtualMasterVec, and a read call per element, too.
+ * A PQVecBatch reads the packed data for a whole range of elements at once and
+ * decodes all of it into a single buffer, which is kept from batch to batch.
+ */
+#ifndef FEUDAL_PQVECBATCH_H_
+#define FEUDAL_PQVECBATCH_H_
+
+#include "feudal/PQVec.h"
+#include "feudal/VirtualMasterVec.h"
+#include "system/Assert.h"
+#include <cstddef>
+#include <vector>
+
+class PQVecBatch
+{
+public:
+    using qual = unsigned char;
+
+    PQVecBatch() : mBegin(0), mOffs(1,0) {}
+    PQVecBatch( PQVecBatch const& )=delete;
+    PQVecBatch& operator=( PQVecBatch const& )=delete;
+
+    /// Unpack elements [begin,end) of an in-memory VecPQVec.
+    void unpack( VecPQVec const& quals, size_t begin, size_t end )
+    { AssertLe(begin,end); AssertLe(end,quals.size());
+      mBegin = begin;
+      mOffs.resize(end-begin+1);
+      size_t off = 0;
+      for ( size_t idx = begin; idx != end; ++idx )
+      { mOffs[idx-begin] = off; off += quals[idx].vSize(); }
+      mOffs.back() = off;
+      mQs.resize(off);
+      for ( size_t idx = begin; idx != end; ++idx )
+        quals[idx].unpack(mQs.data()+mOffs[idx-begin]); }
+
+    /// Unpack elements [begin,end) of a VirtualMasterVec<PQVec>.  This reads
+    /// the packed data with a single read, and decodes it in place.
+    void unpack( VirtualMasterVec<PQVec> const& quals, size_t begin, size_t end )
+    { quals.loadRaw(begin,end,&mRaw,&mRawOffs);
+      mRaw.resize(mRaw.size()+8); // decodeSerial reads whole words
+      mBegin = begin;
+      size_t nnn = end-begin;
+      mOffs.resize(nnn+1);
+      size_t off = 0;
+      for ( size_t idx = 0; idx != nnn; ++idx )
+      { mOffs[idx] = off;
+        if ( mRawOffs[idx] != mRawOffs[idx+1] )
+          off += PQVecEncoder::decodedSize(raw(idx)); }
+      mOffs.back() = off;
+      mQs.resize(off);
+      for ( size_t idx = 0; idx != nnn; ++idx )
+        if ( mRawOffs[idx] != mRawOffs[idx+1] )
+          PQVecEncoder::decode(raw(idx),mQs.data()+mOffs[idx]); }
+
+    /// Index of the first element in the batch.
+    size_t getBegin() const { return mBegin; }
+
+    /// Number of elements in the batch.
+    size_t size() const { return mOffs.size()-1; }
+
+    /// Quals of element getBegin()+idx, as [begin(idx),end(idx)).
+    qual const* begin( size_t idx ) const { return mQs.data()+mOffs[idx]; }
+    qual const* end( size_t idx ) const { return mQs.data()+mOffs[idx+1]; }
+    size_t eleSize( size_t idx ) const { return mOffs[idx+1]-mOffs[idx]; }
+
+private:
+    PQVecEncoder::byte const* raw( size_t idx ) const
+    { return reinterpret_cast<PQVecEncoder::byte const*>(mRaw.data()) +
+                mRawOffs[idx]; }
+
+    size_t mBegin;
+    std::vector<qual> mQs;
+    std::vector<size_t> mOffs;
+    std::vector<char> mRaw;
+    std::vector<size_t> mRawOffs;
+};
+
+#endif /* FEUDAL_PQVECBATCH_H_ */
@@ -31,6 +31,7 @@
 #include "feudal/FeudalFileReader.h"
 #include "feudal/Oob.h"
 #include <cstddef>
+#include <vector>
 
 template<class T>
 class VirtualMasterVec
@@ -106,6 +107,20 @@ public:
       pT->readFeudal(mFFR.getData(idx),mFFR.getDataLen(idx),
                       mFFR.getFixedData(idx,T::fixedDataLen())); }
 
+    /// Read the serialized variable-length data of elements [begin,end) with a
+    /// single read.  pBuf gets the bytes, and pOffs gets end-begin+1 offsets
+    /// into pBuf that delimit each element's data.
+    void loadRaw( size_type begin, size_type end, std::vector<char>* pBuf,
+                    std::vector<size_t>* pOffs ) const
+    { AssertLe(begin,end); AssertLe(end,size());
+      pOffs->resize(end-begin+1);
+      size_t off = 0;
+      for ( size_type idx = begin; idx != end; ++idx )
+      { (*pOffs)[idx-begin] = off; off += mFFR.getDataLen(idx); }
+      pOffs->back() = off;
+      pBuf->resize(off);
+      if ( off ) mFFR.getDataRange(begin,end).read(pBuf->data(),pBuf->data()+off); }
+
     size_type size() const { return mFFR.getNElements(); }
     typename T::size_type eleSize( size_type idx ) const
     { return T::interpretSize(mFFR.getFixedData(idx,T::fixedDataLen()),
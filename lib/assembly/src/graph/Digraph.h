@@ -1472,6 +1472,17 @@ template<class F> class digraphEX : public digraphX {
 
      explicit digraphEX( const digraphE<F>& G );
 
+     // Same, but free the edge objects of G as they are copied, and empty it.
+
+     explicit digraphEX( digraphE<F>&& G );
+
+     void Initialize( const digraphE<F>& G );
+     void Initialize( digraphE<F>&& G );
+
+     // Does this have the same edge objects and adjacencies as G?
+
+     Bool SameAs( const digraphE<F>& G ) const;
+
      // Why isn't this a constructor in digraphE? - because if you do that
      // you need to instantiate digraphEX for all digraphE instantiations.
 
@@ -1588,6 +1599,10 @@ template<class F> class digraphEX : public digraphX {
 
      private:
 
+     // Set everything but the edge objects from G.
+
+     void InitializeGraph( const digraphE<F>& G );
+
      MasterVec<F> edges_;
      VecIntVec to_edge_obj_, from_edge_obj_;
      vec<int> to_left_, to_right_;
@@ -3279,7 +3279,59 @@ template<class E> const E& digraphEX<E>::EdgeObject( int i ) const
      return edges_[i];    }
 
 template<class F> digraphEX<F>::digraphEX( const digraphE<F>& G )
-{    from_.resize( G.N( ) );
+{    Initialize(G);    }
+
+template<class F> digraphEX<F>::digraphEX( digraphE<F>&& G )
+{    Initialize( std::move(G) );    }
+
+template<class F> void digraphEX<F>::Initialize( const digraphE<F>& G )
+{    edges_.clear( ), edges_.resize( G.EdgeObjectCount( ) );
+     #pragma omp parallel for schedule( dynamic, 10000 )
+     for ( int e = 0; e < G.EdgeObjectCount( ); e++ )
+          edges_[e] = G.EdgeObject(e);
+     InitializeGraph(G);    }
+
+// The edges of G and those of a MasterVec come from different pools, so they
+// can't be handed over, only copied.  But each edge of G is freed as soon as
+// it has been copied, rather than all of them at the end.
+
+template<class F> void digraphEX<F>::Initialize( digraphE<F>&& G )
+{    edges_.clear( ), edges_.resize( G.EdgeObjectCount( ) );
+     #pragma omp parallel for schedule( dynamic, 10000 )
+     for ( int e = 0; e < G.EdgeObjectCount( ); e++ )
+     {    edges_[e] = G.EdgeObject(e);
+          F empty;
+          using std::swap;
+          swap( empty, G.EdgesMutable( )[e] );    }
+     InitializeGraph(G);
+     Destroy( G.FromMutable( ) ), Destroy( G.ToMutable( ) );
+     Destroy( G.FromEdgeObjMutable( ) ), Destroy( G.ToEdgeObjMutable( ) );
+     Destroy( G.EdgesMutable( ) );    }
+
+template<class F> Bool digraphEX<F>::SameAs( const digraphE<F>& G ) const
+{    if ( N( ) != G.N( ) || E( ) != G.EdgeObjectCount( ) ) return False;
+     int64_t diffs = 0;
+     #pragma omp parallel for schedule( dynamic, 10000 ) reduction(+:diffs)
+     for ( int e = 0; e < E( ); e++ )
+          if ( !( EdgeObject(e) == G.EdgeObject(e) ) ) diffs++;
+     #pragma omp parallel for schedule( dynamic, 10000 ) reduction(+:diffs)
+     for ( int v = 0; v < N( ); v++ )
+     {    if ( From(v).size( ) != G.From(v).size( )
+               || To(v).size( ) != G.To(v).size( ) )
+          {    diffs++;
+               continue;    }
+          for ( int j = 0; j < G.From(v).isize( ); j++ )
+          {    if ( From(v)[j] != G.From(v)[j] || IFrom( v, j ) != G.IFrom( v, j ) )
+                    diffs++;    }
+          for ( int j = 0; j < G.To(v).isize( ); j++ )
+          {    if ( To(v)[j] != G.To(v)[j] || ITo( v, j ) != G.ITo( v, j ) )
+                    diffs++;    }    }
+     return diffs == 0;    }
+
+template<class F> void digraphEX<F>::InitializeGraph( const digraphE<F>& G )
+{    from_.clear( ), to_.clear( );
+     from_edge_obj_.clear( ), to_edge_obj_.clear( );
+     from_.resize( G.N( ) );
      to_.resize( G.N( ) );
      from_edge_obj_.resize( G.N( ) );
      to_edge_obj_.resize( G.N( ) );
@@ -3296,9 +3348,6 @@ template<class F> digraphEX<F>::digraphEX( const digraphE<F>& G )
           to_edge_obj_[i].resize( G.To(i).size( ) );
           for ( int j = 0; j < G.To(i).isize( ); j++ )
                to_edge_obj_[i][j] = G.ITo( i, j );    }
-     edges_.resize( G.EdgeObjectCount( ) );
-     for ( int e = 0; e < G.EdgeObjectCount( ); e++ )
-          edges_[e] = G.EdgeObject(e);
      to_left_.resize( E( ) ), to_right_.resize( E( ) );
      for ( int v = 0; v < N( ); v++ )
      {    for ( int j = 0; j < (int) From(v).size( ); j++ )
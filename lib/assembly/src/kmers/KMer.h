@@ -23,6 +23,7 @@
 #include "kmers/KMerContext.h"
 #include "math/Hash.h"
 #include "system/StaticAssert.h"
+#include <cstdint>
 #include <iterator>
 #include <limits>
 #include <ostream>
@@ -235,6 +236,44 @@ public:
       { return kmer.hash(); }
     };
 
+    /// A quicker hash than hash():  it mixes the storage 64 bits at a time
+    /// rather than a byte at a time.  It's a different function, so don't
+    /// mix the two on one hash table.
+    unsigned long wordHash() const
+    { unsigned const UNITS_PER_WORD = 64u/BITS_PER_STORAGE_UNIT;
+      uint64_t result = 0;
+      storage_type const* itr = mVal;
+      storage_type const* end = mVal+STORAGE_UNITS_PER_KMER;
+      while ( itr != end )
+      { uint64_t word = *itr++;
+        for ( unsigned idx = 1; idx < UNITS_PER_WORD && itr != end; ++idx )
+          word = (word << (BITS_PER_STORAGE_UNIT%64u)) | *itr++;
+        result = (result ^ word) * 0x9e3779b97f4a7c15ul;
+        result ^= result >> 29; }
+      result *= 0xff51afd7ed558ccdul; result ^= result >> 33;
+      result *= 0xc4ceb9fe1a85ec53ul; result ^= result >> 33;
+      return result; }
+
+    struct WordHasher : public std::unary_function<KMer,unsigned long>
+    {
+      unsigned long operator()( KMer const& kmer ) const
+      { return kmer.wordHash(); }
+    };
+
+    /// Set the kmer from an unsigned integer holding its 2K bits of base
+    /// codes, first base most significant.
+    template <class Bits>
+    KMer& assignBits( Bits bits )
+    { STATIC_ASSERT(BITS_PER_STORAGE_UNIT*STORAGE_UNITS_PER_KMER <=
+                      sizeof(Bits)*8u);
+      bits <<= UNUSED_TRAILING_BITS;
+      storage_type* itr = mVal+STORAGE_UNITS_PER_KMER;
+      while ( true )
+      { *--itr = storage_type(bits);
+        if ( itr == mVal ) break;
+        bits >>= BITS_PER_STORAGE_UNIT; }
+      return *this; }
+
     template <class Itr, class OItr>
     static void kmerize( Itr beg, Itr const& end, OItr out )
     { using std::distance;
@@ -0,0 +1,167 @@
+// Copyright (c) 2016 10X Genomics, Inc. All rights reserved.
+
+/*
+ * \file KmerEdgeIndex.h
+ *
+ * \brief A read-only map from each kmer of a unipath graph to its edge.
+ *
+ * Once the edges are built, all that pathing reads needs to know about a kmer
+ * is which edge it's on, and where.  A KmerDict entry carries the whole kmer,
+ * its KDef, and a barcode, in a HashSet that has room to grow.  A KmerEdgeIndex
+ * is a fixed-size, linearly-probed table of 64-bit slots.  Each slot holds an
+ * edge ID, an offset on that edge, and an 8-bit fingerprint of the kmer's
+ * hash.  The kmer itself isn't stored: when a fingerprint matches, the kmer is
+ * checked against the edge sequence.  So the edges must outlive the index.
+ * The slots are a flat array of plain words.
+ */
+#ifndef KMERS_KMEREDGEINDEX_H_
+#define KMERS_KMEREDGEINDEX_H_
+
+#include "Basevector.h"
+#include "kmers/KMer.h"
+#include "kmers/ReadPather.h"
+#include "kmers/RollingKmerizer.h"
+#include "system/Assert.h"
+#include "system/WorklistN.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+template <unsigned K>
+class KmerEdgeIndex
+{
+public:
+    typedef KMer<K> Kmer;
+
+    /// Index each kmer of each edge.  Each kmer (or its reverse complement)
+    /// must occur on the edges just once, as it does on a unipath graph.
+    explicit KmerEdgeIndex( vecbvec const& edges, double maxLoad = .75 )
+    : mEdges(edges), mNKmers(0)
+    { ForceAssertLt(edges.size(),size_t(EDGE_MASK));
+      for ( bvec const& edge : edges )
+        if ( edge.size() >= K )
+        { size_t nKmers = edge.size()-K+1;
+          ForceAssertLe(nKmers,size_t(OFFSET_MASK)+1);
+          mNKmers += nKmers; }
+      mSlots.resize(std::max(size_t(mNKmers/maxLoad),mNKmers+1),0ul);
+      parallelForBatch(0ul,edges.size(),10000,Inserter(this)); }
+
+    KmerEdgeIndex( KmerEdgeIndex const& ) = delete;
+    KmerEdgeIndex& operator=( KmerEdgeIndex const& ) = delete;
+
+    /// Where the kmer is on the edges, in the same terms as the KDef of its
+    /// dictionary entry (but without a context).  The KDef is null if the
+    /// kmer isn't on any edge.
+    KDef find( Kmer const& kmer ) const
+    { Kmer canon(kmer);
+      if ( canon.isRev() ) canon.rc();
+      return findCanonical(canon,canon.wordHash()); }
+
+    /// Same thing, for a kmer that's already canonical, given its wordHash
+    /// (e.g., from a RollingKmerizer).
+    KDef findCanonical( Kmer const& canon, uint64_t hash ) const
+    { uint64_t fp = fingerprint(hash);
+      KDef result;
+      size_t idx = home(hash);
+      uint64_t slot;
+      while ( (slot = mSlots[idx]) )
+      { if ( (slot >> FP_SHIFT) == fp )
+        { size_t edgeId = slot & EDGE_MASK;
+          unsigned offset = (slot >> OFFSET_SHIFT) & OFFSET_MASK;
+          if ( isAt(canon,mEdges[edgeId],offset,FitsInBits()) )
+          { result.set(EdgeID(edgeId),offset);
+            break; } }
+        if ( ++idx == mSlots.size() ) idx = 0; }
+      return result; }
+
+    /// Start fetching the part of the table where findCanonical will look for
+    /// a kmer with this hash.  Looking up a bunch of kmers goes faster if
+    /// they're all prefetched first.
+    void prefetch( uint64_t hash ) const
+    { __builtin_prefetch(&mSlots[home(hash)]); }
+
+    /// The number of kmers indexed.
+    size_t size() const { return mNKmers; }
+
+    /// The number of bytes in the table.
+    size_t tableBytes() const { return mSlots.size()*sizeof(uint64_t); }
+
+private:
+    class Inserter
+    {
+    public:
+        explicit Inserter( KmerEdgeIndex* pIndex ) : mpIndex(pIndex) {}
+
+        void operator()( size_t edgeId )
+        { bvec const& edge = mpIndex->mEdges[edgeId];
+          mKmerizer.clear();
+          mKmerizer.kmerize(edge.begin(),edge.end());
+          unsigned offset = 0;
+          for ( auto const& item : mKmerizer )
+            mpIndex->insert(item.mHash,edgeId,offset++); }
+
+    private:
+        KmerEdgeIndex* mpIndex;
+        RollingKmerizer<K> mKmerizer;
+    };
+
+    // the table index at which to start looking for a kmer with this hash
+    size_t home( uint64_t hash ) const
+    { return (static_cast<unsigned __int128>(hash)*mSlots.size()) >> 64; }
+
+    // low bits of the hash, since home() uses the high bits; never zero, so
+    // that a zero slot is always empty
+    static uint64_t fingerprint( uint64_t hash )
+    { uint64_t fp = hash & FP_MASK; return fp ? fp : 1u; }
+
+    void insert( uint64_t hash, size_t edgeId, unsigned offset )
+    { uint64_t slot = fingerprint(hash) << FP_SHIFT |
+                        uint64_t(offset) << OFFSET_SHIFT | edgeId;
+      size_t idx = home(hash);
+      while ( !__sync_bool_compare_and_swap(&mSlots[idx],0ul,slot) )
+        if ( ++idx == mSlots.size() ) idx = 0; }
+
+    typedef std::integral_constant<bool,(K <= 64u)> FitsInBits;
+    typedef typename std::conditional<(K <= 32u),uint64_t,
+                                       unsigned __int128>::type Bits;
+
+    // is the canonical kmer, in either orientation, at this place on the edge
+    static bool isAt( Kmer const& canon, bvec const& edge, unsigned offset,
+                        std::false_type )
+    { return std::equal(canon.begin(),canon.end(),edge.begin(offset)) ||
+              std::equal(canon.rcbegin(),canon.rcend(),edge.begin(offset)); }
+
+    // same thing, but build the edge's kmer and its reverse complement 16
+    // bases at a time
+    static bool isAt( Kmer const& canon, bvec const& edge, unsigned offset,
+                        std::true_type )
+    { Bits fwd = 0, rev = 0;
+      for ( unsigned idx = 0; idx < K; idx += 16u )
+      { unsigned nBases = std::min(K-idx,16u);
+        uint32_t mask = ~0u >> (32u-2u*nBases);
+        // extractKmer puts the first base in the low bits, so its complement
+        // is already the reverse complement, first base most significant
+        uint32_t word = edge.extractKmer(offset+idx,nBases);
+        rev |= Bits(~word & mask) << (2u*idx);
+        word = ((word >> 2) & 0x33333333u) | ((word & 0x33333333u) << 2);
+        word = ((word >> 4) & 0x0f0f0f0fu) | ((word & 0x0f0f0f0fu) << 4);
+        word = __builtin_bswap32(word) >> (32u-2u*nBases);
+        fwd = (fwd << (2u*nBases)) | word; }
+      Kmer kmer;
+      if ( kmer.assignBits(fwd) == canon ) return true;
+      return kmer.assignBits(rev) == canon; }
+
+    static unsigned const OFFSET_SHIFT = 32;
+    static unsigned const FP_SHIFT = 56;
+    static uint64_t const EDGE_MASK = (1ul << OFFSET_SHIFT)-1ul;
+    static uint64_t const OFFSET_MASK = (1ul << (FP_SHIFT-OFFSET_SHIFT))-1ul;
+    static uint64_t const FP_MASK = (1ul << (64-FP_SHIFT))-1ul;
+
+    vecbvec const& mEdges;
+    size_t mNKmers;
+    std::vector<uint64_t> mSlots;
+};
+
+#endif /* KMERS_KMEREDGEINDEX_H_ */
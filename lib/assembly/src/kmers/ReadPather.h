@@ -218,12 +218,15 @@ struct Serializability< KmerDictEntry<K> >
 
 
 /// A set of KmerDictEntry's, used as a map from KMer onto KDef.
-template <unsigned K, typename Bcode = BCWrapper >
+/// H hashes a KMer<K>.  Dictionaries that get written to disk must always use
+/// the same one, so it's KMer<K>::Hasher unless you say otherwise.
+template <unsigned K, typename Bcode = BCWrapper,
+            class H = typename KMer<K>::Hasher >
 class KmerDict
 {
 public:
     typedef KmerDictEntry<K, Bcode> Entry;
-    typedef typename KMer<K>::Hasher Hasher;
+    typedef H Hasher;
     typedef std::equal_to<KMer<K> > Comparator;
     typedef HashSet<Entry,Hasher,Comparator> Set;
     typedef typename Set::const_iterator OCItr;
@@ -481,8 +484,8 @@ template <unsigned K>
 struct Serializability< KmerVec<K> >
 { typedef SelfSerializable type; };
 
-template <unsigned K>
-struct Serializability< KmerDict<K> >
+template <unsigned K, typename Bcode, class H>
+struct Serializability< KmerDict<K,Bcode,H> >
 { typedef SelfSerializable type; };
 
 /// An unbranched sequence of kmers.
@@ -106,11 +106,11 @@ private:
 };
 
 // output iterator that increments counts for the kmers in a dictionary
-template <unsigned K>
+template <unsigned K, class Dict = KmerDict<K> >
 class DictionaryKmerEater
 {
 public:
-    DictionaryKmerEater( KmerDict<K>* pDict ) : mpDict(pDict) {}
+    DictionaryKmerEater( Dict* pDict ) : mpDict(pDict) {}
 
     // compiler-supplied copying and destructor are OK
 
@@ -134,7 +134,8 @@ private:
 
         // compiler-supplied copying and destructor are OK
 
-        void operator()( KmerDictEntry<K> const& entry ) const
+        template <class Entry>
+        void operator()( Entry const& entry ) const
         { KDef& kDef = const_cast<KDef&>(entry.getKDef());
           kDef.incrementCount();
           kDef.orContext(mContext); }
@@ -143,7 +144,7 @@ private:
         KMerContext mContext;
     };
 
-    KmerDict<K>* mpDict;
+    Dict* mpDict;
 };
 
 template <unsigned K>
@@ -928,14 +929,14 @@ void PathBuilder<K>::writeEvidence( unsigned nThreads )
 
 } // end of anonymous namespace
 
-template <unsigned K, typename Bcode>
-void KmerDict<K,Bcode>::process( VirtualMasterVec<bvec> const& reads,
+template <unsigned K, typename Bcode, class H>
+void KmerDict<K,Bcode,H>::process( VirtualMasterVec<bvec> const& reads,
                             bool validate, unsigned nThreads, size_t batchSize )
 {
     size_t nReads = reads.size();
     size_t nBatches = (nReads+batchSize-1)/batchSize;
     Dotter dotter(nBatches);
-    typedef DictionaryKmerEater<K> Eater;
+    typedef DictionaryKmerEater<K,KmerDict> Eater;
     typedef VMVProcessor<K,Eater> KProc;
     KProc proc(reads,Eater(this),&dotter);
     if ( !nThreads )
@@ -954,14 +955,14 @@ void KmerDict<K,Bcode>::process( VirtualMasterVec<bvec> const& reads,
     }
 }
 
-template <unsigned K, typename Bcode>
-void KmerDict<K,Bcode>::process( vecbvec const& reads, bool verbose,
+template <unsigned K, typename Bcode, class H>
+void KmerDict<K,Bcode,H>::process( vecbvec const& reads, bool verbose,
                             bool validate, unsigned nThreads, size_t batchSize )
 {
     size_t nReads = reads.size();
     size_t nBatches = (nReads+batchSize-1)/batchSize;
     Dotter dotter(nBatches);
-    typedef DictionaryKmerEater<K> Eater;
+    typedef DictionaryKmerEater<K,KmerDict> Eater;
     typedef vecbvec::const_iterator Itr;
     typedef KmerizationProcessor<K,Eater,Itr> KProc;
     KProc proc(reads.begin(),reads.end(),Eater(this),verbose?&dotter:0);
@@ -0,0 +1,182 @@
+// Copyright (c) 2016 10X Genomics, Inc. All rights reserved.
+
+/*
+ * \file RollingKmerizer.h
+ *
+ * \brief Kmerize reads into canonical kmers, their contexts, and their hashes.
+ *
+ * Kmerizing with KMer::toSuccessor and then canonicalizing each kmer costs a
+ * scan of the bases to decide the canonical form, and, half the time, a byte-
+ * by-byte reverse complement.  Then the hash is computed a byte at a time,
+ * and usually more than once.  A RollingKmerizer keeps a kmer and its reverse
+ * complement as whole integers, updating each of them by one shift as it
+ * moves along the read, so canonicalizing is a single comparison.  It emits
+ * each kmer's word hash (KMer::wordHash) along with the kmer, so that the
+ * caller can reuse it.  Kmers longer than 64 bases don't fit in an integer,
+ * so for those there's a specialization that does it the old way, one KMer
+ * operation at a time, but with the same interface.
+ */
+#ifndef KMERS_ROLLINGKMERIZER_H_
+#define KMERS_ROLLINGKMERIZER_H_
+
+#include "kmers/KMer.h"
+#include "kmers/KMerContext.h"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+template <unsigned K, bool FITS = (K <= 64u)>
+class RollingKmerizer
+{
+public:
+    typedef KMer<K> Kmer;
+
+    // a canonical kmer, its context (also canonical), and its wordHash
+    struct Item
+    {
+        Kmer mKmer;
+        KMerContext mContext;
+        uint64_t mHash;
+    };
+
+    typedef typename std::vector<Item>::const_iterator const_iterator;
+
+    RollingKmerizer() : mNItems(0)
+    { for ( unsigned pred = 0; pred <= NO_BASE; ++pred )
+        for ( unsigned succ = 0; succ <= NO_BASE; ++succ )
+        { KMerContext kc;
+          if ( pred != NO_BASE ) kc.setPredecessor(pred);
+          if ( succ != NO_BASE ) kc.setSuccessor(succ);
+          mContexts[pred][succ][0] = kc;
+          mContexts[pred][succ][1] = kc.rc(); } }
+
+    // compiler-supplied copying and destructor are OK
+
+    /// Discard the items from previous calls to kmerize.
+    void clear() { mNItems = 0; }
+
+    /// Append an Item for each kmer in the base codes [beg,end).  The first
+    /// and last kmers have no predecessor and no successor, respectively.
+    template <class Itr>
+    void kmerize( Itr beg, Itr end )
+    { size_t len = end-beg;
+      if ( len < K ) return;
+      size_t nItems = mNItems + len-K+1;
+      if ( mItems.size() < nItems ) mItems.resize(nItems);
+      Item* pItem = &mItems[mNItems];
+      mNItems = nItems;
+      Bits fwd = 0, rev = 0;
+      Itr itr = beg;
+      for ( unsigned idx = 1; idx < K; ++idx )
+        push(*itr++,fwd,rev);
+      unsigned char pred = NO_BASE;
+      while ( true )
+      { push(*itr++,fwd,rev);
+        if ( itr == end )
+        { emit(fwd,rev,pred,NO_BASE,*pItem);
+          break; }
+        emit(fwd,rev,pred,*itr,*pItem++);
+        pred = fwd >> REV_SHIFT; } }
+
+    const_iterator begin() const { return mItems.begin(); }
+    const_iterator end() const { return mItems.begin()+mNItems; }
+    size_t size() const { return mNItems; }
+
+private:
+    typedef typename std::conditional<(K <= 32u),uint64_t,
+                                       unsigned __int128>::type Bits;
+
+    static unsigned char const NO_BASE = 4;
+    static unsigned const REV_SHIFT = 2u*(K-1u);
+    static unsigned const MID_SHIFT = 2u*(K/2u);
+
+    static Bits mask()
+    { unsigned const BITS = 8u*sizeof(Bits);
+      return 2u*K == BITS ? ~Bits(0) : (Bits(1) << (2u*K%BITS)) - 1u; }
+
+    static void push( unsigned char base, Bits& fwd, Bits& rev )
+    { fwd = ((fwd << 2) | base) & mask();
+      rev = (rev >> 2) | (Bits(base^3u) << REV_SHIFT); }
+
+    // Odd kmers are canonical when the middle base is A or C.  Even ones are
+    // canonical when they're no greater than their reverse complement.
+    static bool isRev( Bits fwd, Bits rev )
+    { if ( K&1 ) return (fwd >> MID_SHIFT) & 2u;
+      return rev < fwd; }
+
+    void emit( Bits fwd, Bits rev, unsigned char pred, unsigned char succ,
+                Item& item ) const
+    { // which way to go is a coin flip, so don't branch on it
+      bool isRC = isRev(fwd,rev);
+      Bits revMask = -Bits(isRC);
+      item.mKmer.assignBits((rev & revMask) | (fwd & ~revMask));
+      item.mContext = mContexts[pred][succ][isRC];
+      item.mHash = item.mKmer.wordHash(); }
+
+    // context given predecessor, successor (or NO_BASE), and whether it's RC
+    KMerContext mContexts[NO_BASE+1][NO_BASE+1][2];
+    std::vector<Item> mItems;
+    size_t mNItems;
+};
+
+template <unsigned K>
+class RollingKmerizer<K,false>
+{
+public:
+    typedef KMer<K> Kmer;
+
+    struct Item
+    {
+        Kmer mKmer;
+        KMerContext mContext;
+        uint64_t mHash;
+    };
+
+    typedef typename std::vector<Item>::const_iterator const_iterator;
+
+    RollingKmerizer() : mNItems(0) {}
+
+    // compiler-supplied copying and destructor are OK
+
+    void clear() { mNItems = 0; }
+
+    template <class Itr>
+    void kmerize( Itr beg, Itr end )
+    { size_t len = end-beg;
+      if ( len < K ) return;
+      size_t nItems = mNItems + len-K+1;
+      if ( mItems.size() < nItems ) mItems.resize(nItems);
+      Item* pItem = &mItems[mNItems];
+      mNItems = nItems;
+      Itr itr = beg+K;
+      Kmer kkk(beg);
+      KMerContext kc;
+      if ( itr != end ) kc = KMerContext::initialContext(*itr);
+      while ( true )
+      { emit(kkk,kc,*pItem++);
+        if ( itr == end )
+          break;
+        unsigned char pred = kkk.front();
+        kkk.toSuccessor(*itr);
+        kc = ++itr == end ? KMerContext::finalContext(pred) :
+                            KMerContext(pred,*itr); } }
+
+    const_iterator begin() const { return mItems.begin(); }
+    const_iterator end() const { return mItems.begin()+mNItems; }
+    size_t size() const { return mNItems; }
+
+private:
+    static void emit( Kmer const& kkk, KMerContext kc, Item& item )
+    { item.mKmer = kkk;
+      item.mContext = kc;
+      if ( kkk.isRev() )
+      { item.mKmer.rc();
+        item.mContext = kc.rc(); }
+      item.mHash = item.mKmer.wordHash(); }
+
+    std::vector<Item> mItems;
+    size_t mNItems;
+};
+
+#endif /* KMERS_ROLLINGKMERIZER_H_ */
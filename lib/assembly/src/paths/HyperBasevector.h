@@ -234,6 +234,22 @@ class HyperBasevectorX : public digraphEX<basevector> {
           : digraphEX<basevector>( (const digraphE<basevector>&) hb )
      {    K_ = hb.K( );    }
 
+     // Same, but free the edges of hb as they are copied, leaving hb empty.
+
+     explicit HyperBasevectorX( HyperBasevector&& hb )
+          : digraphEX<basevector>( std::move( (digraphE<basevector>&) hb ) )
+     {    K_ = hb.K( );    }
+
+     // Assigning a new HyperBasevectorX( hb ) would make a temporary copy;
+     // these convert in place.
+
+     void Initialize( const HyperBasevector& hb )
+     {    Superclass::Initialize( (const digraphE<basevector>&) hb );
+          K_ = hb.K( );    }
+     void Initialize( HyperBasevector&& hb )
+     {    Superclass::Initialize( std::move( (digraphE<basevector>&) hb ) );
+          K_ = hb.K( );    }
+
      int K( ) const { return K_; }
 
      int Bases( int e ) const { return EdgeObject(e).size( ); }
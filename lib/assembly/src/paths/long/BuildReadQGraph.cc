@@ -6,7 +6,7 @@
 //   Institute is not responsible for its use, misuse, or functionality.     //
 ///////////////////////////////////////////////////////////////////////////////
 /*
- * BuildReadQGraph48.cc
+ * BuildReadQGraph.cc
  *
  *  Created on: Jan 22, 2014
  *      Author: tsharpe
@@ -14,7 +14,7 @@
 
 #define MEM(X) { cout << #X << ": mem = " << MemUsageGBString( ) << ", peak = " << PeakMemUsageGBString( ) << endl; }
 
-#include "paths/long/BuildReadQGraph48.h"
+#include "paths/long/BuildReadQGraph.h"
 #include "Basevector.h"
 #include "FastaFileset.h"
 #include "Intvector.h"
@@ -26,70 +26,70 @@
 #include "Vec.h"
 #include "dna/Bases.h"
 #include "feudal/BinaryStream.h"
+#include "feudal/IncrementalWriter.h"
 #include "feudal/VirtualMasterVec.h"
 //#include "kmers/BigKPather.h"
+#include "kmers/KmerEdgeIndex.h"
 #include "kmers/ReadPatherDefs.h"
+#include "kmers/RollingKmerizer.h"
 #include "math/Functions.h"
 #include "paths/KmerBaseBroker.h"
 #include "paths/UnibaseUtils.h"
 #include "paths/long/HBVFromEdges.h"
 #include "paths/long/KmerCount.h"
+#include "system/LockedData.h"
 #include "system/SortInPlace.h"
 #include "system/SpinLockedData.h"
+#include "system/Worklist.h"
 #include "system/WorklistN.h"
 #include <algorithm>
 #include <atomic>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <numeric>
 #include <utility>
 #include <vector>
 #include "paths/HyperBasevector.h"
 #include "paths/long/ExtendReadPath.h"
+#include "paths/long/GoodLens.h"
 #include "paths/long/ShortKmerReadPather.h"
 #include "10X/MakeHist.h"
+#include "10X/paths/ReadPathVecX.h"
 
 namespace
 {
-unsigned const K = 48;
-typedef KMer<K> Kmer;
-typedef KMer<K-1> SubKmer;
-template <typename B>
+// Everything that depends on K is templated on it, and instantiated for each
+// K that buildReadQGraph dispatches to.  The kmers use the default 32-bit
+// storage: the rest of a dictionary entry is a 4-byte-aligned 12 bytes, so no
+// narrower word makes an entry any smaller, and 64-bit words often make it
+// bigger.
+template <unsigned K, typename B>
 using Entry =  KmerDictEntry<K,B>;
-template <typename B>
-using Dict = KmerDict<K, B>;
-typedef KmerVec<K> KVec;
-typedef UnipathGraph<K> Graph;
-typedef std::vector<std::atomic_size_t> SpectrumBins;
+template <unsigned K, typename B>
+using Dict = KmerDict<K, B, typename KMer<K>::WordHasher>;
 
 class GoodLenTailFinder
 {
 public:
-    GoodLenTailFinder( VecPQVec const& quals, unsigned minQual,
+    GoodLenTailFinder( VecPQVec const& quals, unsigned K, unsigned minQual,
                         std::vector<unsigned>* pGoodLens )
-    : mQuals(quals), mMinQual(minQual), mGoodLens(*pGoodLens) {}
+    : mQuals(quals), mK(K), mMinQual(minQual), mGoodLens(*pGoodLens) {}
 
     void operator()( size_t readId )
     { mQuals[readId].unpack(&mQV);
-      unsigned minQual = mMinQual;
-      auto itr = mQV.end();
-      auto beg = mQV.begin();
-      unsigned good = 0;
-      while ( itr != beg )
-        if ( *--itr < minQual ) good = 0;
-        else if ( ++good == K )
-        { mGoodLens[readId] = (itr-beg)+K; return; }
-      mGoodLens[readId] = 0; }
+      mGoodLens[readId] = GoodLens::goodLen(mQV.begin(),mQV.end(),mK,mMinQual); }
 
 private:
     VecPQVec const& mQuals;
+    unsigned mK;
     unsigned mMinQual;
     std::vector<unsigned>& mGoodLens;
     qvec mQV;
 };
 
-template <typename B>
-inline void summarizeEntries( Entry<B>* e1, Entry<B>* e2 )
+template <class E>
+inline void summarizeEntries( E* e1, E* e2 )
 {
     KMerContext kc;
     size_t count = 0;
@@ -104,8 +104,8 @@ inline void summarizeEntries( Entry<B>* e1, Entry<B>* e2 )
     kDef.setCount(count);
 }
 
-template <typename B>
-inline bool areIgnoredBarcodes( Entry<B>* e1, Entry<B>* e2 )
+template <class E>
+inline bool areIgnoredBarcodes( E* e1, E* e2 )
 {
      while ( e2-- != e1 ) {
           if (e2->getTempBC() == -1 ) return true;
@@ -113,8 +113,8 @@ inline bool areIgnoredBarcodes( Entry<B>* e1, Entry<B>* e2 )
      return false;
 }
 
-template <typename B>
-inline bool areEnoughBarcodes( Entry<B>* e1, Entry<B>* e2, unsigned mMinBC )
+template <class E>
+inline bool areEnoughBarcodes( E* e1, E* e2, unsigned mMinBC )
 {
      // this is not done in summarizeEntries because doing so
      // would require counting uniqueness in a large set when mMinBC is
@@ -136,21 +136,44 @@ inline bool areEnoughBarcodes( Entry<B>* e1, Entry<B>* e2, unsigned mMinBC )
      return ( count >= mMinBC );
 }
 
-template <typename B>
+// kmer count histogram, accumulated by the Kmerizers as they reduce
+class KmerSpectrum : public SpinLockedData
+{
+public:
+    void add( std::vector<size_t> const& counts )
+    { SpinLocker lock(*this);
+      if ( mCounts.size() < counts.size() ) mCounts.resize(counts.size(),0);
+      for ( size_t idx = 0; idx != counts.size(); ++idx )
+        mCounts[idx] += counts[idx]; }
+
+    void write( String const& jsonDir )
+    { int64_t maxCount = mCounts.size()-1;
+      while ( maxCount >= 0 && mCounts[maxCount] == 0 )
+        maxCount--;
+      mCounts.resize(maxCount+1);
+      WriteHistToJson(mCounts,int64_t(0),maxCount,int64_t(1),jsonDir,
+                        "kmer_count","DF"); }
+
+private:
+    vec<int64_t> mCounts;
+};
+
+template <unsigned K, typename B>
 class Kmerizer
 {
 public:
-    using EntryType = Entry<B>;
+    using EntryType = Entry<K,B>;
     Kmerizer( vecbvec const& reads, std::vector<unsigned> const& goodLengths,
                 unsigned minFreq, int64_t ignBcBelow, unsigned minBC, vec<int32_t> const* pBC,
-                KVec* pKVec, std::atomic_size_t* pTotKmers )
+                Dict<K,B>* pDict, KmerSpectrum* pSpectrum )
     : mReads(reads), mGoodLengths(goodLengths), mMinFreq(minFreq),
       mIgnBcBelow(ignBcBelow), mMinBC(minBC), mpBC(pBC),
-      mpKVec(pKVec), mpTotKmers(pTotKmers), mNKmers(0)
+      mpDict(pDict), mpSpectrum(pSpectrum)
     {}
 
+    // each thread's copy adds its piece of the spectrum as it goes away
     ~Kmerizer()
-    { if ( mpTotKmers ) *mpTotKmers += mNKmers; }
+    { if ( !mSpectrum.empty() ) mpSpectrum->add(mSpectrum); }
 
     template <class OItr>
     void map( size_t readId, OItr oItr )
@@ -158,27 +181,23 @@ public:
       int32_t bc = -1;
       if ( readId >= mIgnBcBelow && mpBC ) bc = (*mpBC)[readId];
       if ( len < K+1 ) return;
-      auto beg = mReads[readId].begin(), itr=beg+K, last=beg+(len-1);
-      Kmer kkk(beg);
-      KMerContext kc = KMerContext::initialContext(*itr);
-      *oItr++ = kkk.isRev() ? EntryType(Kmer(kkk).rc(),kc.rc(),bc) : EntryType(kkk,kc,bc);
-      while ( itr != last )
-      { unsigned char pred = kkk.front();
-        kkk.toSuccessor(*itr); ++itr;
-        kc = KMerContext(pred,*itr);
-        *oItr++ = kkk.isRev() ? EntryType(Kmer(kkk).rc(),kc.rc(),bc) : EntryType(kkk,kc,bc); }
-      kc = KMerContext::finalContext(kkk.front());
-      kkk.toSuccessor(*last);
-      *oItr++ = kkk.isRev() ? EntryType(Kmer(kkk).rc(),kc.rc(),bc) : EntryType(kkk,kc,bc); }
+      auto beg = mReads[readId].begin();
+      mKmerizer.clear();
+      mKmerizer.kmerize(beg,beg+len);
+      for ( auto const& item : mKmerizer )
+        *oItr++ = HashedKey<EntryType>(EntryType(item.mKmer,item.mContext,bc),
+                                        item.mHash); }
 
     void reduce( EntryType* e1, EntryType* e2 )
     { summarizeEntries(e1,e2);
       bool bc_test = true;
       if ( mpBC ) bc_test = \
            areIgnoredBarcodes(e1, e2) || areEnoughBarcodes(e1, e2, mMinBC);
-      if ( e1->getKDef().getCount() >= mMinFreq && bc_test )
-      { ++mNKmers;
-        if ( mpKVec ) mpKVec->insertEntry(std::move(*e1)); } }
+      size_t count = e1->getKDef().getCount();
+      if ( count >= mMinFreq && bc_test )
+      { if ( count >= mSpectrum.size() ) mSpectrum.resize(count+1,0);
+        mSpectrum[count] += 1;
+        mpDict->insertEntry(std::move(*e1)); } }
 
     EntryType* overflow( EntryType* e1, EntryType* e2 )
     { if ( e2-e1 > 1 ) summarizeEntries(e1,e2); return e1+1; }
@@ -190,43 +209,53 @@ private:
     int64_t mIgnBcBelow;
     unsigned mMinBC;
     vec<int32_t> const* mpBC;
-    KVec* mpKVec;
-    std::atomic_size_t* mpTotKmers;
-    size_t mNKmers;
+    Dict<K,B>* mpDict;
+    KmerSpectrum* mpSpectrum;
+    std::vector<size_t> mSpectrum;
+    RollingKmerizer<K> mKmerizer;
 };
-typedef MapReduceEngine<Kmerizer<BCWrapper>,Entry<BCWrapper>,Kmer::Hasher> KMRE;
 
-void WriteKmerSpectrum( KVec * pVec, String JSON_DIR = "" )
-{
-     vec<int64_t> kmerspec(1000000, 0);
-     cout << Date( ) << ": computing spectrum" << endl;
-     for ( auto itr = pVec->begin(); itr != pVec->end(); ++itr ) {
-          const int count = itr->getKDef().getCount();
-          if ( kmerspec.isize() <= count )
-               kmerspec.resize( count+1, 0 );
-          kmerspec[count]++;
-     }
-     // prune back
-     int64_t max_count = kmerspec.size()-1;
-     while (max_count >= 0 && kmerspec[max_count] == 0)
-          max_count--;
-     kmerspec.resize(max_count+1);
-     if ( JSON_DIR != "" )
-          WriteHistToJson(kmerspec, int64_t(0), max_count, int64_t(1), JSON_DIR, "kmer_count", "DF");
-}
+// The dictionary is sized before we know how many distinct kmers there are, by
+// guessing that each solid kmer occurs about this many times, as it does at the
+// coverage we're usually given.  A low guess isn't fatal: each sub-table that
+// fills is split in two, and the table of sub-tables doubles as needed, so the
+// dictionary grows geometrically.  But each split rehashes, so we log a miss.
+size_t const EXPECTED_KMER_MULTIPLICITY = 32;
 
-Dict<BCWrapper>* createDict( String const& work_dir, vecbvec const& reads, ObjectManager<VecPQVec>& quals,
+template <unsigned K>
+Dict<K,BCWrapper>* createDict( String const& work_dir, String const& read_head,
+                        vecbvec const& reads, ObjectManager<VecPQVec>& quals,
                         unsigned minQual, unsigned minFreq, int64_t ignBcBelow = 0,
                         float const mem_frac = 0.9,
-                         unsigned minBC = 2, vec<int32_t> const* bcp = nullptr )
+                         unsigned minBC = 2, vec<int32_t> const* bcp = nullptr,
+                         String const& spillDir = "" )
 {
-    // figure out how much of the read to kmerize by examining quals
-    //std::cout << Date() << ": processing quals." << std::endl;
-    std::vector<unsigned> goodLens(reads.size());
-    MEM(before_parallelForBatch_lens);
-    parallelForBatch(0ul,reads.size(),100000,
-                         GoodLenTailFinder(quals.load(),minQual,&goodLens));
-    MEM(after_parallelForBatch_lens);
+    typedef MapReduceEngine<Kmerizer<K,BCWrapper>,Entry<K,BCWrapper>,
+                            typename KMer<K>::WordHasher> KMRE;
+
+    // figure out how much of the read to kmerize -- the initial scan of the
+    // quals usually did this already
+    std::vector<unsigned> goodLens;
+    String goodLensFile = work_dir + read_head + ".goodlens";
+    if ( IsRegularFile(goodLensFile) )
+    {
+        GoodLens gl;
+        BinaryReader::readFile(goodLensFile,&gl);
+        if ( gl.matches(K,minQual,reads.size()) )
+        {
+            std::cout << Date() << ": using good lengths from "
+                        << goodLensFile << std::endl;
+            goodLens.swap(gl.lens());
+        }
+    }
+    if ( goodLens.empty() && !reads.empty() )
+    {
+        goodLens.resize(reads.size());
+        MEM(before_parallelForBatch_lens);
+        parallelForBatch(0ul,reads.size(),100000,
+                         GoodLenTailFinder(quals.load(),K,minQual,&goodLens));
+        MEM(after_parallelForBatch_lens);
+    }
     quals.unload();
     MEM(after_quals_unload);
     size_t nKmers = std::accumulate(goodLens.begin(),goodLens.end(),0ul);
@@ -241,74 +270,35 @@ Dict<BCWrapper>* createDict( String const& work_dir, vecbvec const& reads, Objec
 //    const size_t max_mem = 360;
 //    SetMaxMemory( round( max_mem * 1024.0 * 1024.0 * 1024.0 ) );
 
-#if 0
-    size_t dictSize;
-    if ( true )
-    { // count uniq kmers that occur at minFreq or more
-        std::atomic_size_t nUniqKmers(0);
-        Kmerizer impl(reads,goodLens,minFreq,ignBcBelow,minBC,bcp,nullptr,&nUniqKmers);
-        KMRE mre(impl);
-        if ( !mre.run(nKmers,0ul,reads.size(),
-				KMRE::VERBOSITY::QUIET, mem_frac) )
-            FatalErr("Failed to count unique kmers.  Out of buffer space.  ");
-        dictSize = nUniqKmers;
-    }
-
-    // kmerize reads into dictionary
+    // kmerize reads directly into the dictionary
 
     cout << Date( ) << ": creating dictionary" << endl;
-    Dict* pDict = new Dict(dictSize);
-    Kmerizer impl(reads,goodLens,minFreq,ignBcBelow,minBC,bcp,pDict,nullptr);
-    KMRE mre(impl);
-    if ( !mre.run(nKmers,0ul,reads.size(),
-			    KMRE::VERBOSITY::QUIET, mem_frac) )
-        FatalErr("Failed to kmerize.  Out of buffer space.  ");
-#endif
-    size_t dictSize;
+    size_t dictSize = std::max(nKmers/EXPECTED_KMER_MULTIPLICITY,1ul);
+    Dict<K,BCWrapper>* pDict = new Dict<K,BCWrapper>(dictSize,0.9);
+    MEM(alloc_dict);
+    KmerSpectrum spectrum;
     if ( true )
-    { // count uniq kmers that occur at minFreq or more
-        std::atomic_size_t nUniqKmers(0);
-        Kmerizer<BCWrapper> impl(reads,goodLens,minFreq,ignBcBelow,minBC,bcp,nullptr,&nUniqKmers);
+    {   Kmerizer<K,BCWrapper> impl(reads, goodLens, minFreq, ignBcBelow, minBC, bcp,
+                                    pDict, &spectrum);
         KMRE mre(impl);
+        if ( spillDir != "" ) mre.setSpillDir(spillDir);
         if ( !mre.run(nKmers,0ul,reads.size(),
-				KMRE::VERBOSITY::QUIET, mem_frac) )
-            FatalErr("Failed to count unique kmers.  Out of buffer space.  ");
-        dictSize = nUniqKmers;
+                        KMRE::VERBOSITY::NOISY, mem_frac) )
+            FatalErr("Failed to kmerize.  Out of buffer space.  ");
     }
+    MEM(after_create_dict);
+    size_t const nDistinct = pDict->size();
+    PRINT( nDistinct );
+    if ( nDistinct > dictSize || 4*nDistinct < dictSize )
+        cout << Date( ) << ": dictionary was sized for " << dictSize
+             << " kmers, but holds " << nDistinct << ", so kmers occur about "
+             << nKmers/std::max(nDistinct,1ul) << " times each, not "
+             << EXPECTED_KMER_MULTIPLICITY << endl;
 
-//    KVec* pVec = new KVec(reads.size()*(150-48)/50);
-    KVec* pVec = new KVec(dictSize);
-    PRINT( pVec->size() );
-    Kmerizer<BCWrapper> impl(reads, goodLens, minFreq, ignBcBelow, minBC, bcp, pVec, nullptr);
-    KMRE mre(impl);
-    if ( !mre.run(nKmers,0ul,reads.size(),
-			    KMRE::VERBOSITY::NOISY, mem_frac) )
-        FatalErr("Failed to kmerize.  Out of buffer space.  ");
-
-    pVec->fit();    // fit to the available data
-    
     String JSON_DIR = work_dir + "/stats";
     Mkdir777( JSON_DIR );
-    WriteKmerSpectrum( pVec, JSON_DIR );
-
-    cout << Date() << ": writing kmers.kvec" << endl;
-    BinaryWriter::writeFile( work_dir+"/kmers.kvec", *pVec );
-    auto nkmers = pVec->size();
-    MEM(before_delete_pvec);
-    delete pVec;
-    MEM(after_delete_pvec);
-
-    BinaryIteratingReader<KVec> vecReader( work_dir+"/kmers.kvec" );
-
-    MEM(after_kmer_before_dict);
-    Dict<BCWrapper>* pDict = new Dict<BCWrapper>(nkmers,0.9);
-    MEM(alloc_dict);
-    for ( auto itr = vecReader.begin(); itr != vecReader.end(); ++itr )
-         pDict->insertEntry(*itr);
-    MEM(after_create_dict);
-
-    Remove( work_dir+"/kmers.kvec" );
-
+    cout << Date( ) << ": writing spectrum" << endl;
+    spectrum.write(JSON_DIR);
 
 //    SetMaxMemory(mm);
 
@@ -324,12 +314,14 @@ Dict<BCWrapper>* createDict( String const& work_dir, vecbvec const& reads, Objec
     return pDict;
 }
 
-template <typename B>
+template <unsigned K, typename B>
 class EdgeBuilder
 {
 public:
-    using EntryType = Entry<B>;
-    EdgeBuilder( Dict<B> const& dict, vecbvec* pEdges )
+    using EntryType = Entry<K,B>;
+    typedef KMer<K> Kmer;
+    typedef KMer<K-1> SubKmer;
+    EdgeBuilder( Dict<K,B> const& dict, vecbvec* pEdges )
     : mDict(dict), mEdges(*pEdges) {}
 
     void buildEdge( EntryType const& entry )
@@ -505,19 +497,19 @@ private:
         mEdgeSeq.clear();
         mEdgeEntries.clear(); }
 
-    Dict<B> const& mDict;
+    Dict<K,B> const& mDict;
     vecbvec& mEdges;
     std::vector<EntryType const*> mEdgeEntries;
     bvec mEdgeSeq;
 };
 
-template <typename B>
-void buildEdges( Dict<B> const& dict, vecbvec* pEdges )
+template <unsigned K, typename B>
+void buildEdges( Dict<K,B> const& dict, vecbvec* pEdges )
 {
-    using EntryType = Entry<B>;
-    EdgeBuilder<B> eb(dict,pEdges);
+    using EntryType = Entry<K,B>;
+    EdgeBuilder<K,B> eb(dict,pEdges);
     dict.parallelForEachHHS(
-            [eb]( typename Dict<B>::Set::HHS const& hhs ) mutable
+            [eb]( typename Dict<K,B>::Set::HHS const& hhs ) mutable
             { for ( EntryType const& entry : hhs )
                 if ( entry.getKDef().isNull() )
                   eb.buildEdge(entry); });
@@ -693,14 +685,19 @@ private:
     unsigned mEdgeLen;
 };
 
-template <typename B>
+template <unsigned K>
 class Pather
 {
 public:
-    using EntryType = Entry<B>;
+    typedef KMer<K> Kmer;
+    typedef KMer<K-1> SubKmer;
 
-    Pather( Dict<B> const& dict, vecbvec const& edges )
-    : mDict(dict), mEdges(edges) {}
+    // prefetchDepth is how many kmers of a gap to hash and prefetch before
+    // looking any of them up
+    Pather( KmerEdgeIndex<K> const& index, vecbvec const& edges,
+            unsigned prefetchDepth = DEFAULT_PATHING_PREFETCH_DEPTH )
+    : mIndex(index), mEdges(edges),
+      mPrefetchDepth(std::max(prefetchDepth,1u)) {}
 
     std::vector<PathPart> const& path( bvec const& read )
     { mPathParts.clear();
@@ -709,41 +706,32 @@ public:
       { mPathParts.emplace_back(read.size());
         return mPathParts; } // EARLY RETURN!
 
-      auto itr = read.begin();
-      auto end = read.end()-K+1;
-      while ( itr != end )
-      { Kmer kmer(itr);
-        EntryType const* pEnt = mDict.findEntry(kmer);
-        if ( !pEnt )
-        {
-          unsigned gapLen = 1u;
-          auto itr2 = itr+K; ++itr;
-          auto end2 = read.end();
-          while ( itr2 != end2 )
-          { kmer.toSuccessor(*itr2); ++itr2;
-            if ( (pEnt = mDict.findEntry(kmer)) )
-                break;
-            ++gapLen; ++itr; }
-          mPathParts.emplace_back(gapLen); }
-        if ( pEnt )
-        { KDef const& kDef = pEnt->getKDef();
-          bvec const& edge = mEdges[kDef.getEdgeID().val()];
-          int offset = kDef.getEdgeOffset();
-          auto eBeg(edge.begin(offset));
-          size_t len = 1u;
-          bool rc = CF<K>::isRC(itr,eBeg);
-          if ( !rc )
-            len += matchLen(itr+K,read.end(),eBeg+K,edge.end());
-          else
-          { offset = edge.size() - offset;
-            auto eBegRC(edge.rcbegin(offset));
-            len += matchLen(itr+K,read.end(),eBegRC,edge.rcend());
-            offset = offset - K; }
-          unsigned edgeKmers = edge.size()-K+1;
-
-          mPathParts.emplace_back(kDef.getEdgeID(),rc,offset,len,edgeKmers);
-          itr += len;
-        } }
+      size_t nKmers = read.size()-K+1;
+      size_t pos = 0;
+      while ( pos != nKmers )
+      { KDef kDef;
+        size_t hitPos = nextOnEdge(read,pos,nKmers,&kDef);
+        if ( hitPos != pos )
+          mPathParts.emplace_back(unsigned(hitPos-pos));
+        if ( hitPos == nKmers )
+          break;
+        auto itr = read.begin(hitPos);
+        bvec const& edge = mEdges[kDef.getEdgeID().val()];
+        int offset = kDef.getEdgeOffset();
+        auto eBeg(edge.begin(offset));
+        size_t len = 1u;
+        bool rc = CF<K>::isRC(itr,eBeg);
+        if ( !rc )
+          len += matchLen(itr+K,read.end(),eBeg+K,edge.end());
+        else
+        { offset = edge.size() - offset;
+          auto eBegRC(edge.rcbegin(offset));
+          len += matchLen(itr+K,read.end(),eBegRC,edge.rcend());
+          offset = offset - K; }
+        unsigned edgeKmers = edge.size()-K+1;
+
+        mPathParts.emplace_back(kDef.getEdgeID(),rc,offset,len,edgeKmers);
+        pos = hitPos + len; }
       return mPathParts; }
 
     std::vector<PathPart> const& path_careful(bvec const& read) {
@@ -758,8 +746,8 @@ public:
         auto end = read.end() - K + 1;
         while (itr != end) {
             Kmer kmer(itr);
-            EntryType const* pEnt = mDict.findEntry(kmer);
-            if (!pEnt) {
+            KDef kDef = mIndex.find(kmer);
+            if (kDef.isNull()) {
                 unsigned gapLen = 1u;
                 auto itr2 = itr + K;
                 ++itr;
@@ -767,7 +755,7 @@ public:
                 while (itr2 != end2) {
                     kmer.toSuccessor(*itr2);
                     ++itr2;
-                    if ((pEnt = mDict.findEntry(kmer)))
+                    if (!(kDef = mIndex.find(kmer)).isNull())
                         break;
                     ++gapLen;
                     ++itr;
@@ -777,8 +765,7 @@ public:
                 else
                     mPathParts.emplace_back(gapLen);
             }
-            if (pEnt) {
-                KDef const& kDef = pEnt->getKDef();
+            if (!kDef.isNull()) {
                 bvec const& edge = mEdges[kDef.getEdgeID().val()];
                 int offset = kDef.getEdgeOffset();
                 auto eBeg(edge.begin(offset));
@@ -833,26 +820,25 @@ public:
         while ( itr != end ) {
             int qSumRemain = 21;        // reset per edge
             Kmer kmer(itr);
-            EntryType const* pEnt = mDict.findEntry(kmer);
+            KDef kDef = mIndex.find(kmer);
             int gapLen = 0;
-            if ( !pEnt ) {
+            if ( kDef.isNull() ) {
                 ++gapLen;
                 auto itr2 = itr+K; ++itr;
                 auto end2 = read.end();
                 while ( itr2 != end2 ) {
                     kmer.toSuccessor(*itr2); ++itr2;
-                    if ( (pEnt = mDict.findEntry(kmer)) )
+                    if ( !(kDef = mIndex.find(kmer)).isNull() )
                         break;
                     ++gapLen; ++itr;
                 }
             }
-            // if still !pEnt, then we found no good kmers, so register the gap
+            // if still no kDef, then we found no good kmers, so register the gap
             // otherwise we look to extend the match in both directions and possibly
             // adjust the gap later.
-            if ( !pEnt ) {
+            if ( kDef.isNull() ) {
                 mPathParts.emplace_back(gapLen);
             } else {
-                KDef const& kDef = pEnt->getKDef();
                 bvec const& edge = mEdges[kDef.getEdgeID().val()];
                 int offset = kDef.getEdgeOffset();
                 auto eBeg(edge.begin(offset));
@@ -901,19 +887,45 @@ public:
       return os; }
 
 private:
-    Dict<B> const& mDict;
+    // The position of the first kmer at or after pos that's on an edge (or
+    // nKmers, if none is).  The kmer at pos usually is, so it's looked up by
+    // itself.  After that we're in a gap, which is often K kmers long, and
+    // each lookup is a cache miss.  So we hash mPrefetchDepth kmers, prefetch
+    // their slots in the index, and then look them up.
+    size_t nextOnEdge( bvec const& read, size_t pos, size_t nKmers, KDef* pKDef )
+    { size_t nWanted = 1;
+      while ( pos != nKmers )
+      { size_t nItems = std::min(nWanted,nKmers-pos);
+        mKmerizer.clear();
+        mKmerizer.kmerize(read.begin(pos),read.begin(pos+nItems+K-1));
+        if ( nItems > 1 )
+          for ( auto const& item : mKmerizer )
+            mIndex.prefetch(item.mHash);
+        for ( auto const& item : mKmerizer )
+        { *pKDef = mIndex.findCanonical(item.mKmer,item.mHash);
+          if ( !pKDef->isNull() )
+            return pos;
+          ++pos; }
+        nWanted = mPrefetchDepth; }
+      return pos; }
+
+    KmerEdgeIndex<K> const& mIndex;
     vecbvec const& mEdges;
+    unsigned mPrefetchDepth;
+    RollingKmerizer<K> mKmerizer;
     std::vector<PathPart> mPathParts;
 };
 
-template <typename B>
+template <unsigned K, typename B>
 class GapFiller
 {
 public:
-    using EntryType = Entry<B>;
-    GapFiller( vecbvec const& reads, vecbvec const& edges, unsigned maxGapSize,
-                    unsigned minFreq, Dict<B>* pDict )
-    : mReads(reads), mDict(*pDict), mPather(*pDict,edges),
+    using EntryType = Entry<K,B>;
+    typedef KMer<K> Kmer;
+    GapFiller( vecbvec const& reads, vecbvec const& edges,
+                    KmerEdgeIndex<K> const& index, unsigned maxGapSize,
+                    unsigned minFreq, Dict<K,B>* pDict )
+    : mReads(reads), mDict(*pDict), mPather(index,edges),
       mMaxGapSize(maxGapSize), mMinFreq(minFreq) {}
 
     template <class OItr>
@@ -966,19 +978,21 @@ private:
 
     static unsigned const MAX_JITTER = 1;
     vecbvec const& mReads;
-    Dict<B>& mDict;
-    Pather<B> mPather;
+    Dict<K,B>& mDict;
+    Pather<K> mPather;
     unsigned mMaxGapSize;
     unsigned mMinFreq;
 };
-typedef MapReduceEngine<GapFiller<BCWrapper>,Entry<BCWrapper>,Kmer::Hasher> GFMRE;
 
-template <typename B>
+template <unsigned K, typename B>
 void fillGaps( vecbvec const& reads, unsigned maxGapSize, unsigned minFreq,
-                    vecbvec* pEdges, Dict<B>* pDict )
+                    vecbvec* pEdges, Dict<K,B>* pDict )
 {
+    typedef MapReduceEngine<GapFiller<K,B>,Entry<K,B>,
+                            typename KMer<K>::WordHasher> GFMRE;
     cout << Date() << ": filling gaps." << endl;
-    GapFiller<B> gf(reads,*pEdges,maxGapSize,minFreq,pDict);
+    KmerEdgeIndex<K> index(*pEdges);
+    GapFiller<K,B> gf(reads,*pEdges,index,maxGapSize,minFreq,pDict);
     GFMRE mre(gf);
 
     if ( !mre.run(5*reads.size(),0ul,reads.size()) )
@@ -993,12 +1007,13 @@ void fillGaps( vecbvec const& reads, unsigned maxGapSize, unsigned minFreq,
     buildEdges(*pDict,pEdges);
 }
 
-template <typename B>
-void pathRef( String const& refFasta, Dict<B> const& dict, vecbvec const& edges )
+template <unsigned K>
+void pathRef( String const& refFasta, KmerEdgeIndex<K> const& index,
+                vecbvec const& edges )
 {
     vecbvec ref;
     FastFetchReads(ref,nullptr,refFasta);
-    Pather<B> pather(dict,edges);
+    Pather<K> pather(index,edges);
     for ( bvec const& refTig : ref )
     {
         pather.path(refTig);
@@ -1052,14 +1067,15 @@ private:
     unsigned mOverlap;
 };
 
-template <typename B>
+template <unsigned K>
 class Joiner
 {
 public:
-    Joiner( vecbvec const& reads, vecbvec const& edges, Dict<B> const& dict,
+    Joiner( vecbvec const& reads, vecbvec const& edges,
+                    KmerEdgeIndex<K> const& index,
                     unsigned maxGapSize, unsigned minFreq,
                     vecbvec* pFakeReads )
-    : mReads(reads), mEdges(edges), mPather(dict,edges),
+    : mReads(reads), mEdges(edges), mPather(index,edges),
       mMaxGapSize(maxGapSize), mMinFreq(minFreq), mFakeReads(*pFakeReads)
     { ForceAssertLt(maxGapSize,K-1); }
 
@@ -1134,24 +1150,26 @@ private:
 
     vecbvec const& mReads;
     vecbvec const& mEdges;
-    Pather<B> mPather;
+    Pather<K> mPather;
     unsigned mMaxGapSize;
     unsigned mMinFreq;
     vecbvec& mFakeReads;
 };
-typedef MapReduceEngine<Joiner<BCWrapper>,Join,Join::Hasher> JMRE;
 
-template <typename B>
+template <unsigned K, typename B>
 void joinOverlaps( vecbvec const& reads, unsigned maxGapSize, unsigned minFreq,
-                        vecbvec* pEdges, Dict<B>* pDict )
+                        vecbvec* pEdges, Dict<K,B>* pDict )
 {
+    typedef MapReduceEngine<Joiner<K>,Join,Join::Hasher> JMRE;
     //std::cout << Date() << ": joining overlaps." << std::endl;
     vecbvec fakeReads;
     fakeReads.reserve(pEdges->size()/10);
-    Joiner<B> joiner(reads,*pEdges,*pDict,maxGapSize,minFreq,&fakeReads);
-    JMRE mre(joiner);
-    if ( !mre.run(reads.size(),0ul,reads.size()) )
-        FatalErr("Map/Reduce operation failed when joining overlaps.");
+    if ( true )
+    { KmerEdgeIndex<K> index(*pEdges);
+      Joiner<K> joiner(reads,*pEdges,index,maxGapSize,minFreq,&fakeReads);
+      JMRE mre(joiner);
+      if ( !mre.run(reads.size(),0ul,reads.size()) )
+          FatalErr("Map/Reduce operation failed when joining overlaps."); }
 
     if ( fakeReads.size() )
     {
@@ -1167,20 +1185,20 @@ void joinOverlaps( vecbvec const& reads, unsigned maxGapSize, unsigned minFreq,
 }
 
 
-template <typename B>
+template <unsigned K>
 class HBVPather
 {
 public:
     typedef enum {ALGORITHM_ONE, ALGORITHM_TWO} Algorithm;
 
     HBVPather( VirtualMasterVec<BaseVec> const& reads, VirtualMasterVec<PQVec> quals,
-                Dict<B> const& dict, vecbvec const& edges,
+                KmerEdgeIndex<K> const& index, vecbvec const& edges,
                 HyperBasevector const& hbv,
                 vec<int> const& fwdEdgeXlat, vec<int> const& revEdgeXlat,
-                Algorithm alg, ReadPathVec* pPaths, Bool const verbose = False )
+                Algorithm alg, unsigned prefetchDepth, Bool const verbose = False )
     : mReads(reads), mQuals(quals), mHBV(hbv), mFwdEdgeXlat(fwdEdgeXlat),
-      mRevEdgeXlat(revEdgeXlat), mPather(dict,edges), mAlgorithm(alg),
-      mPaths(*pPaths), mPathsOffset(0u), mVerbose(verbose),
+      mRevEdgeXlat(revEdgeXlat), mPather(index,edges,prefetchDepth), mAlgorithm(alg),
+      mpPaths(0), mPathsOffset(0u), mVerbose(verbose),
       mExtender(mHBV,&mToLeft,&mToRight,mVerbose) {
         mHBV.ToLeft(mToLeft);
         mHBV.ToRight(mToRight);
@@ -1202,8 +1220,9 @@ public:
         }
     }
 
-    void setPathsOffset(size_t off ) { mPathsOffset = off; }
-    size_t getPathsOffset() { return mPathsOffset; }
+    // the path of read ID readId goes into (*pPaths)[readId-offset]
+    void setPaths( ReadPathVec* pPaths, size_t offset )
+    { mpPaths = pPaths; mPathsOffset = offset; }
 
     size_t startOnRead( std::vector<PathPart> const& parts )
     {
@@ -1332,7 +1351,7 @@ public:
 
         if ( debug )
             cout << "id #" << readId << ": new ReadPath=" << mPath << endl;
-        mPaths[readId-mPathsOffset] = mPath;
+        (*mpPaths)[readId-mPathsOffset] = mPath;
     }
 
     void algorithmOne( size_t readId )
@@ -1372,7 +1391,7 @@ public:
           PRINT(mPath);
       }
 
-      mPaths[readId] = mPath;
+      (*mpPaths)[readId-mPathsOffset] = mPath;
     }
 
     size_t pathPartToEdgeID( PathPart const& part ) const
@@ -1427,9 +1446,9 @@ private:
     vec<int> mToLeft, mToRight;
     vec<int> const& mFwdEdgeXlat;
     vec<int> const& mRevEdgeXlat;
-    Pather<B> mPather;
+    Pather<K> mPather;
     Algorithm mAlgorithm;
-    ReadPathVec& mPaths;
+    ReadPathVec* mpPaths;
     size_t mPathsOffset;
     ReadPath mPath;
     Bool mVerbose;
@@ -1437,35 +1456,129 @@ private:
     qvec mQV;
 };
 
-template <typename B>
+// A slice of the reads' paths, and the same paths compressed, a block per batch
+// of reads.
+struct PathsSlice
+{
+    ReadPathVec mPaths;
+    vec<ReadPathVecX> mBlocks;
+};
+
+// Slices that are done with, for reuse.  At most maxSlices are ever made: if
+// they're all in use, get() waits for the writer to put() one back, so that
+// pathing can't run ahead of writing by more than that.
+class PathsSlicePool : public LockedData
+{
+public:
+    explicit PathsSlicePool( size_t maxSlices )
+    : mMaxSlices(maxSlices), mNSlices(0), mCondFree(*this)
+    { ForceAssertGt(maxSlices,0u); }
+    PathsSlicePool( PathsSlicePool const& ) = delete;
+    PathsSlicePool& operator=( PathsSlicePool const& ) = delete;
+    ~PathsSlicePool() { for ( PathsSlice* pSlice : mFree ) delete pSlice; }
+
+    PathsSlice* get()
+    { Locker lock(*this);
+      if ( mFree.empty() && mNSlices < mMaxSlices )
+      { mNSlices += 1; return new PathsSlice; }
+      while ( mFree.empty() ) lock.wait(mCondFree);
+      PathsSlice* pSlice = mFree.back();
+      mFree.pop_back();
+      return pSlice; }
+
+    void put( PathsSlice* pSlice )
+    { Locker lock(*this);
+      mFree.push_back(pSlice);
+      mCondFree.signal(); }
+
+private:
+    size_t mMaxSlices;
+    size_t mNSlices;
+    Condition mCondFree; // predicate "a slice is free"
+    std::vector<PathsSlice*> mFree;
+};
+
+// Appends each slice's compressed paths to a ReadPathVecX and, if there's a
+// writer, writes its uncompressed paths, too.  It runs on a thread of its own,
+// taking slices in the order they were pathed.
+class PathsSliceWriter
+{
+public:
+    PathsSliceWriter( ReadPathVecX* pPathsX, IncrementalWriter<ReadPath>* pOut,
+                        PathsSlicePool* pPool )
+    : mpPathsX(pPathsX), mpOut(pOut), mpPool(pPool) {}
+
+    void operator()( PathsSlice* pSlice )
+    { mpPathsX->append(pSlice->mBlocks);
+      if ( mpOut )
+        for ( ReadPath const& path : pSlice->mPaths )
+          mpOut->add(path);
+      mpPool->put(pSlice); }
+
+private:
+    ReadPathVecX* mpPathsX;
+    IncrementalWriter<ReadPath>* mpOut;
+    PathsSlicePool* mpPool;
+};
+
+// Path the reads in slices of batchsize*ncores reads.  Each thread compresses
+// the paths of its batch as soon as it's pathed them, and a writer thread
+// gathers up the compressed blocks (and writes the paths to paths_file, unless
+// it's empty) while the next slice is being pathed.
+template <unsigned K>
 void pathReads( VirtualMasterVec<BaseVec> const& reads, VirtualMasterVec<PQVec>& quals,
-                Dict<B> const& dict, vecbvec const& edges,
+                KmerEdgeIndex<K> const& index, vecbvec const& edges,
                 HyperBasevector const& hbv,
                 vec<int> const& fwdEdgeXlat, vec<int> const& revEdgeXlat,
-                String const& paths_file, Bool const NEW_ALIGNER = False,
-                Bool const VERBOSE = False )
+                ReadPathVecX* pPathsX, String const& paths_file,
+                unsigned const prefetchDepth,
+                Bool const NEW_ALIGNER = False, Bool const VERBOSE = False )
 {
     auto ncores = getConfiguredNumThreads();
     size_t batchsize = 500000;
-    ReadPathVec pPaths;
-    IncrementalWriter<ReadPath> out_paths(paths_file);
-    auto algorithm = NEW_ALIGNER ? HBVPather<B>::ALGORITHM_TWO : HBVPather<B>::ALGORITHM_ONE;
-    HBVPather<B> pather(reads.clone(),quals.clone(),dict,edges,hbv,fwdEdgeXlat,revEdgeXlat,
-              algorithm,&pPaths,VERBOSE);
+    HyperBasevectorX hbx(hbv);
+    auto algorithm = NEW_ALIGNER ? HBVPather<K>::ALGORITHM_TWO : HBVPather<K>::ALGORITHM_ONE;
+    HBVPather<K> pather(reads.clone(),quals.clone(),index,edges,hbv,fwdEdgeXlat,revEdgeXlat,
+              algorithm,prefetchDepth,VERBOSE);
 
     ForceAssertGt(reads.size(), 0u);
-    size_t maxIter = ( reads.size() - 1 ) / ( batchsize*ncores ) + 1;
-    for ( size_t iter = 0; iter < maxIter; ++iter ) {
-         cout << Date() << ": pathing iteration " << iter+1 << " of " << maxIter << endl;
-         size_t offset = batchsize*ncores*iter;
-         pPaths.resize(ncores*batchsize);
-         pather.setPathsOffset(offset);
-         size_t this_run = std::min( offset+batchsize*ncores, reads.size() );
-         parallelForBatch(offset,this_run,batchsize,pather);
-         for ( size_t i = 0; i < this_run - offset; ++i )
-              out_paths.add(pPaths[i]);
-         pPaths.clear();
+    int64_t const skip = pPathsX->getSkip();
+    pPathsX->clear();
+    pPathsX->setSkip(skip);
+    pPathsX->reserve(reads.size());
+    std::unique_ptr<IncrementalWriter<ReadPath>> pOut;
+    if ( !paths_file.empty() )
+        pOut.reset(new IncrementalWriter<ReadPath>(paths_file,reads.size()));
+    // one slice being pathed while the last one is written
+    PathsSlicePool pool(2);
+    if ( true ) // block to control lifetime of the writer thread
+    { Worklist<PathsSlice*,PathsSliceWriter>
+            writer(PathsSliceWriter(pPathsX,pOut.get(),&pool),1);
+      size_t maxIter = ( reads.size() - 1 ) / ( batchsize*ncores ) + 1;
+      for ( size_t iter = 0; iter < maxIter; ++iter ) {
+           cout << Date() << ": pathing iteration " << iter+1 << " of " << maxIter << endl;
+           size_t offset = batchsize*ncores*iter;
+           size_t this_run = std::min( offset+batchsize*ncores, reads.size() );
+           PathsSlice* pSlice = pool.get();
+           // a fresh set of empty paths, since some reads don't get one
+           pSlice->mPaths.clear();
+           pSlice->mPaths.resize(this_run-offset);
+           pSlice->mBlocks.resize((this_run-offset+batchsize-1)/batchsize);
+           pather.setPaths(&pSlice->mPaths,offset);
+           parallelFor(0ul,pSlice->mBlocks.size(),
+               [offset,this_run,batchsize,pSlice,&hbx,pather]( size_t batchNo ) mutable
+               { size_t beg = offset+batchNo*batchsize;
+                 size_t end = std::min(beg+batchsize,this_run);
+                 for ( size_t readId = beg; readId != end; ++readId )
+                      pather(readId);
+                 ReadPathVecX& block = pSlice->mBlocks[batchNo];
+                 block.clear();
+                 block.append(pSlice->mPaths,hbx,beg-offset,end-beg); },
+               ncores);
+           writer.add(pSlice);
+      }
     }
+    if ( pOut ) pOut->close();
 }
 
 void repathUnpathedReads(const vecbvec& reads, const VecPQVec& quals,
@@ -1627,14 +1740,18 @@ void mspEdgesToHBV( vec<basevector> const& edges, HyperBasevector& hbv, const in
      buildHBVFromEdges(vedges, K, &hbv, &fwdEdgeXlat, &revEdgeXlat);
 }
 
+namespace
+{
 
+template <unsigned K>
 void buildGraphFromMSP( String const& work_dir, 
         String const& reads_name,
         String const& quals_name,
         String const& MSPEDGES,
         HyperBasevector& hbv, 
-        const int K, 
-        ReadPathVec& paths)
+        ReadPathVecX& pathsX,
+        String const& paths_file,
+        unsigned const prefetchDepth)
 {
      MEM(before_msp_graph);
      vec<basevector> medges;
@@ -1648,22 +1765,12 @@ void buildGraphFromMSP( String const& work_dir,
      mspEdgesToHBV(medges, hbv, K, fwdEdgeXlat, revEdgeXlat);
      cout << Date() << ": after mspEdgesToHBV" << endl;
 
-     size_t nKmers = 0;
-     for ( int i = 0; i < medges.isize(); ++i ) 
-          nKmers += medges[i].size() - (K-1);
-
-     MEM(before_msp_dict);
-     Dict<BCEmpty> dict(nKmers, 0.9);
-     for ( int e = 0; e < medges.isize(); ++e ) {
-          auto const& edge = medges[e];
-          for ( int i = 0; i < edge.isize() - K + 1; ++i ) {
-               Kmer kmer( edge.begin(i) );
-               EdgeID edgeid(e);
-               dict[kmer].set(edgeid,i);
-          }
-     }
-     MEM(after_msp_dict);
-     cout << Date() << ": populated dictionary covers " << ToStringAddCommas(dict.size()) << " kmers" << endl;
+     vecbasevector edges(medges.begin(), medges.end());
+
+     MEM(before_msp_index);
+     KmerEdgeIndex<K> index(edges);
+     MEM(after_msp_index);
+     cout << Date() << ": kmer index covers " << ToStringAddCommas(index.size()) << " kmers" << endl;
 
 
      cout << Date( ) << ": virtualing quals, mem = " << MemUsageGBString( ) << endl;
@@ -1673,19 +1780,16 @@ void buildGraphFromMSP( String const& work_dir,
      cout << Date( ) << ": pathing reads, mem = " << MemUsageGBString( ) << endl;
      auto const& hbv_edges=hbv.Edges();
 
-     vecbasevector edges(medges.begin(), medges.end());
-
      MEM(before_msp_path);
      cout << Date() << ": pathing reads" << endl;
-     pathReads(vreads,vquals,dict,edges,hbv,
-               fwdEdgeXlat,revEdgeXlat,work_dir+"/tmp.paths",True,False);
+     pathReads(vreads,vquals,index,edges,hbv,
+               fwdEdgeXlat,revEdgeXlat,&pathsX,paths_file,prefetchDepth,True,False);
      cout << Date() << ": done pathing reads" << endl;
      MEM(after_msp_path);
 }
 
-
-
-void buildReadQGraph48(String const& work_dir,
+template <unsigned K>
+void buildReadQGraph(String const& work_dir,
                        String const& read_head,
                        std::string const mspFilename,
                        vecbvec& reads, ObjectManager<VecPQVec>& quals,
@@ -1696,15 +1800,18 @@ void buildReadQGraph48(String const& work_dir,
                        double minFreq2Fract, unsigned maxGapSize,
                        String const& refFasta,
                        bool useNewAligner, bool repathUnpathed,
-                       HyperBasevector* pHBV, ReadPathVec* pPaths,
+                       HyperBasevector* pHBV, ReadPathVecX* pPathsX,
+                       String const& pathsFile,
                        float const memFrac,
-                       bool const VERBOSE )
+                       bool const VERBOSE,
+                       String const& spillDir,
+                       unsigned const prefetchDepth )
 {
   ForceAssertEq(doFillGaps, False);
   ForceAssertEq(doJoinOverlaps, False);
   ForceAssertEq(repathUnpathed, False);
   vecbvec edges;
-  Dict<BCWrapper> *pDict;
+  Dict<K,BCWrapper> *pDict;
 
   if (mspFilename.size() > 0) {
        FatalErr("old Msp not supported");
@@ -1713,7 +1820,7 @@ void buildReadQGraph48(String const& work_dir,
 
     MEM(before_create_dict);
 
-    pDict = createDict(work_dir,reads,quals,minQual,minFreq,ignBcBelow,memFrac,minBC,bcp);
+    pDict = createDict<K>(work_dir,read_head,reads,quals,minQual,minFreq,ignBcBelow,memFrac,minBC,bcp,spillDir);
 
     MEM(after_create_dict);
 
@@ -1733,15 +1840,21 @@ void buildReadQGraph48(String const& work_dir,
 
 //  if ( doJoinOverlaps ) joinOverlaps(reads,K/2,minFreq2,&edges,pDict);
 
-  if ( !refFasta.empty() ) pathRef(refFasta,*pDict,edges);
+  // from here on, all we need to know about a kmer is where it is on the
+  // edges, and a KmerEdgeIndex of the edges tells us that in much less space
+  delete pDict;
+  pDict = 0;
+  MEM(after_delete_dict);
+
+  if ( !refFasta.empty() )
+  { KmerEdgeIndex<K> index(edges);
+    pathRef(refFasta,index,edges); }
 
   vec<int> fwdEdgeXlat;
   vec<int> revEdgeXlat;
-  if ( !pPaths )
+  if ( !pPathsX )
     {
       cout << Date( ) << ": building from edges 1" << endl;
-      delete pDict;
-      pDict = 0;
       buildHBVFromEdges(edges,K,pHBV,&fwdEdgeXlat,&revEdgeXlat);
     }
   else
@@ -1753,6 +1866,11 @@ void buildReadQGraph48(String const& work_dir,
 
       buildHBVFromEdges(edges,K,pHBV,&fwdEdgeXlat,&revEdgeXlat);
       MEM(after_edges);
+      cout << Date( ) << ": indexing kmers" << endl;
+      KmerEdgeIndex<K> index(edges);
+      cout << Date( ) << ": kmer index covers " << ToStringAddCommas(index.size())
+           << " kmers in " << ToStringAddCommas(index.tableBytes()) << " bytes" << endl;
+      MEM(after_kmer_index);
       cout << Date( ) << ": pathing reads" << endl;
       quals.unload();
       MEM(quals_unload);
@@ -1762,13 +1880,102 @@ void buildReadQGraph48(String const& work_dir,
       cout << Date( ) << ": virtualing bases, mem = " << MemUsageGBString( ) << endl;
       VirtualMasterVec<BaseVec> vreads( work_dir + read_head + ".fastb" );
       cout << Date( ) << ": pathing reads, mem = " << MemUsageGBString( ) << endl;
-      pathReads(vreads,vquals,*pDict,edges,*pHBV,
-                fwdEdgeXlat,revEdgeXlat,work_dir+"/tmp.paths",useNewAligner,VERBOSE);
+      pathReads(vreads,vquals,index,edges,*pHBV,
+                fwdEdgeXlat,revEdgeXlat,pPathsX,pathsFile,prefetchDepth,
+                useNewAligner,VERBOSE);
       MEM(after_pathing);
-      delete pDict;
-      pDict = 0;
-      MEM(after_delete_dict);
+    }
+}
+
+} // end of anonymous namespace
 
-      // paths now read back in DF.cc as pathsX
+bool isGraphK( int K )
+{
+    return K >= 32 && K <= 96 && K % 4 == 0;
+}
+
+void buildGraphFromMSP( String const& work_dir, 
+        String const& reads_name,
+        String const& quals_name,
+        String const& MSPEDGES,
+        HyperBasevector& hbv, 
+        const int K, 
+        ReadPathVecX& pathsX,
+        String const& paths_file,
+        unsigned const prefetchDepth)
+{
+    switch ( K ) {
+    case 32: buildGraphFromMSP<32>(work_dir,reads_name,quals_name,MSPEDGES,hbv,pathsX,paths_file,prefetchDepth); break;
+    case 36: buildGraphFromMSP<36>(work_dir,reads_name,quals_name,MSPEDGES,hbv,pathsX,paths_file,prefetchDepth); break;
+    case 40: buildGraphFromMSP<40>(work_dir,reads_name,quals_name,MSPEDGES,hbv,pathsX,paths_file,prefetchDepth); break;
+    case 44: buildGraphFromMSP<44>(work_dir,reads_name,quals_name,MSPEDGES,hbv,pathsX,paths_file,prefetchDepth); break;
+    case 48: buildGraphFromMSP<48>(work_dir,reads_name,quals_name,MSPEDGES,hbv,pathsX,paths_file,prefetchDepth); break;
+    case 52: buildGraphFromMSP<52>(work_dir,reads_name,quals_name,MSPEDGES,hbv,pathsX,paths_file,prefetchDepth); break;
+    case 56: buildGraphFromMSP<56>(work_dir,reads_name,quals_name,MSPEDGES,hbv,pathsX,paths_file,prefetchDepth); break;
+    case 60: buildGraphFromMSP<60>(work_dir,reads_name,quals_name,MSPEDGES,hbv,pathsX,paths_file,prefetchDepth); break;
+    case 64: buildGraphFromMSP<64>(work_dir,reads_name,quals_name,MSPEDGES,hbv,pathsX,paths_file,prefetchDepth); break;
+    case 68: buildGraphFromMSP<68>(work_dir,reads_name,quals_name,MSPEDGES,hbv,pathsX,paths_file,prefetchDepth); break;
+    case 72: buildGraphFromMSP<72>(work_dir,reads_name,quals_name,MSPEDGES,hbv,pathsX,paths_file,prefetchDepth); break;
+    case 76: buildGraphFromMSP<76>(work_dir,reads_name,quals_name,MSPEDGES,hbv,pathsX,paths_file,prefetchDepth); break;
+    case 80: buildGraphFromMSP<80>(work_dir,reads_name,quals_name,MSPEDGES,hbv,pathsX,paths_file,prefetchDepth); break;
+    case 84: buildGraphFromMSP<84>(work_dir,reads_name,quals_name,MSPEDGES,hbv,pathsX,paths_file,prefetchDepth); break;
+    case 88: buildGraphFromMSP<88>(work_dir,reads_name,quals_name,MSPEDGES,hbv,pathsX,paths_file,prefetchDepth); break;
+    case 92: buildGraphFromMSP<92>(work_dir,reads_name,quals_name,MSPEDGES,hbv,pathsX,paths_file,prefetchDepth); break;
+    case 96: buildGraphFromMSP<96>(work_dir,reads_name,quals_name,MSPEDGES,hbv,pathsX,paths_file,prefetchDepth); break;
+    default:
+      FatalErr( "buildGraphFromMSP: Not implemented for K=" << K << "." );
+    }
+}
+
+void buildReadQGraph(unsigned K,
+                       String const& work_dir,
+                       String const& read_head,
+                       std::string const mspFilename,
+                       vecbvec& reads, ObjectManager<VecPQVec>& quals,
+                       bool doFillGaps, bool doJoinOverlaps,
+                       unsigned minQual, unsigned minFreq,
+                       int64_t const ignBcBelow,
+                       unsigned minBC, vec<int32_t> const* bcp,
+                       double minFreq2Fract, unsigned maxGapSize,
+                       String const& refFasta,
+                       bool useNewAligner, bool repathUnpathed,
+                       HyperBasevector* pHBV, ReadPathVecX* pPathsX,
+                       String const& pathsFile,
+                       float const memFrac,
+                       bool const VERBOSE,
+                       String const& spillDir,
+                       unsigned const prefetchDepth )
+{
+    void (*build)( String const&, String const&, std::string const,
+                   vecbvec&, ObjectManager<VecPQVec>&, bool, bool,
+                   unsigned, unsigned, int64_t const, unsigned,
+                   vec<int32_t> const*, double, unsigned, String const&,
+                   bool, bool, HyperBasevector*, ReadPathVecX*, String const&,
+                   float const,
+                   bool const, String const&, unsigned const );
+    switch ( K ) {
+    case 32: build = buildReadQGraph<32>; break;
+    case 36: build = buildReadQGraph<36>; break;
+    case 40: build = buildReadQGraph<40>; break;
+    case 44: build = buildReadQGraph<44>; break;
+    case 48: build = buildReadQGraph<48>; break;
+    case 52: build = buildReadQGraph<52>; break;
+    case 56: build = buildReadQGraph<56>; break;
+    case 60: build = buildReadQGraph<60>; break;
+    case 64: build = buildReadQGraph<64>; break;
+    case 68: build = buildReadQGraph<68>; break;
+    case 72: build = buildReadQGraph<72>; break;
+    case 76: build = buildReadQGraph<76>; break;
+    case 80: build = buildReadQGraph<80>; break;
+    case 84: build = buildReadQGraph<84>; break;
+    case 88: build = buildReadQGraph<88>; break;
+    case 92: build = buildReadQGraph<92>; break;
+    case 96: build = buildReadQGraph<96>; break;
+    default:
+      FatalErr( "buildReadQGraph: Not implemented for K=" << K << "." );
     }
+    build(work_dir,read_head,mspFilename,reads,quals,doFillGaps,doJoinOverlaps,
+          minQual,minFreq,ignBcBelow,minBC,bcp,minFreq2Fract,maxGapSize,
+          refFasta,useNewAligner,repathUnpathed,pHBV,pPathsX,pathsFile,memFrac,VERBOSE,
+          spillDir,prefetchDepth);
 }
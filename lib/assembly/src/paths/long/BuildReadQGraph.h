@@ -6,26 +6,39 @@
 //   Institute is not responsible for its use, misuse, or functionality.     //
 ///////////////////////////////////////////////////////////////////////////////
 /*
- * BuildReadQGraph48.h
+ * BuildReadQGraph.h
  *
  *  Created on: Jan 22, 2014
  *      Author: tsharpe
  */
 
-#ifndef PATHS_LONG_BUILDREADQGRAPH_48_H_
-#define PATHS_LONG_BUILDREADQGRAPH_48_H_
+#ifndef PATHS_LONG_BUILDREADQGRAPH_H_
+#define PATHS_LONG_BUILDREADQGRAPH_H_
 
 #include "String.h"
 #include "feudal/ObjectManager.h"
 #include "feudal/PQVec.h"
 #include "paths/HyperBasevector.h"
 #include "paths/long/ReadPath.h"
+#include "10X/paths/ReadPathVecX.h"
 
+// The graph builder is compiled for each K that's a multiple of 4 from 32 to 96
+// inclusive.  This says whether K is one of those.
+bool isGraphK( int K );
+
+// The read pather looks up the kmers of a gap in a read this many at a time,
+// having hashed them all and prefetched their slots in the kmer index.
+unsigned const DEFAULT_PATHING_PREFETCH_DEPTH = 8;
+
+// Both of these path the reads on the graph into pathsX (buildReadQGraph only
+// if pPathsX isn't null), and also write the paths to paths_file, unless it's
+// empty.
 void buildGraphFromMSP( String const& work_dir, String const& reads_name, 
           String const& quals_name, String const& MSPEDGES, HyperBasevector& hbv, 
-          const int K, ReadPathVec& paths);
+          const int K, ReadPathVecX& pathsX, String const& paths_file,
+          unsigned prefetchDepth = DEFAULT_PATHING_PREFETCH_DEPTH );
 
-void buildReadQGraph48(String const& work_dir, String const& read_head, 
+void buildReadQGraph(unsigned K, String const& work_dir, String const& read_head,
                         std::string const mspFilename,
                         vecbvec& reads, ObjectManager<VecPQVec>& quals,
                         bool doFillGaps, bool doJoinOverlaps,
@@ -35,8 +48,11 @@ void buildReadQGraph48(String const& work_dir, String const& read_head,
                         double minFreq2Fract, unsigned maxGapSize,
                         String const& refFasta,
         		         bool useNewAligner, bool repathUnpathed,
-                        HyperBasevector* pHBV, ReadPathVec* pPaths,
+                        HyperBasevector* pHBV, ReadPathVecX* pPathsX,
+                        String const& pathsFile,
 				    float const meanMemFrac = 0.9,
-                        bool const VERBOSE = False );
+                        bool const VERBOSE = False,
+                        String const& spillDir = "",
+                        unsigned prefetchDepth = DEFAULT_PATHING_PREFETCH_DEPTH );
 
-#endif /* PATHS_LONG_BUILDREADQGRAPH_48_H_ */
+#endif /* PATHS_LONG_BUILDREADQGRAPH_H_ */
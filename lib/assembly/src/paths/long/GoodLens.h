@@ -0,0 +1,69 @@
+// Copyright (c) 2016 10X Genomics, Inc. All rights reserved.
+
+/*
+ * \file GoodLens.h
+ *
+ * \brief How much of each read the graph builder kmerizes.
+ *
+ * A read is cut after the last run of K consecutive quals that are all at
+ * least minQual, and is ignored entirely if it has no such run.  The lengths
+ * are computed during the initial scan of the quals (see GetQualStats), and
+ * are stored next to the reads, so that building the graph doesn't need to
+ * load and decode the quals again.
+ */
+#ifndef PATHS_LONG_GOODLENS_H_
+#define PATHS_LONG_GOODLENS_H_
+
+#include "Qualvector.h"
+#include "feudal/BinaryStream.h"
+#include <cstddef>
+#include <vector>
+
+class GoodLens
+{
+public:
+    GoodLens() : mK(0), mMinQual(0) {}
+    GoodLens( unsigned K, unsigned minQual, size_t nReads )
+    : mK(K), mMinQual(minQual), mLens(nReads) {}
+
+    unsigned getK() const { return mK; }
+    unsigned getMinQual() const { return mMinQual; }
+    size_t size() const { return mLens.size(); }
+
+    /// Were these computed with the given parameters for nReads reads?
+    bool matches( unsigned K, unsigned minQual, size_t nReads ) const
+    { return mK == K && mMinQual == minQual && mLens.size() == nReads; }
+
+    /// Good length of a read having quals [beg,end).
+    template <class Itr>
+    static unsigned goodLen( Itr beg, Itr end, unsigned K, unsigned minQual )
+    { Itr itr = end;
+      unsigned good = 0;
+      while ( itr != beg )
+        if ( *--itr < minQual ) good = 0;
+        else if ( ++good == K ) return (itr-beg)+K;
+      return 0; }
+
+    void set( size_t readId, qvec const& qv )
+    { mLens[readId] = goodLen(qv.begin(),qv.end(),mK,mMinQual); }
+
+    std::vector<unsigned>& lens() { return mLens; }
+    std::vector<unsigned> const& lens() const { return mLens; }
+
+    void writeBinary( BinaryWriter& writer ) const
+    { writer.write(mK); writer.write(mMinQual); writer.write(mLens); }
+
+    void readBinary( BinaryReader& reader )
+    { reader.read(&mK); reader.read(&mMinQual); reader.read(&mLens); }
+
+    static size_t externalSizeof() { return 0; }
+
+private:
+    unsigned mK;
+    unsigned mMinQual;
+    std::vector<unsigned> mLens;
+};
+
+SELF_SERIALIZABLE(GoodLens);
+
+#endif /* PATHS_LONG_GOODLENS_H_ */
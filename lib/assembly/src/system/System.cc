@@ -29,6 +29,9 @@
 
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <linux/fs.h>
 
 #include <algorithm>
 #include <fstream>
@@ -291,6 +294,23 @@ void SymlinkForce( String existing_file, String name_of_symbolic_link )
 {    Remove(name_of_symbolic_link);
      Symlink( existing_file, name_of_symbolic_link );    }
 
+String AdoptFile( String const& file1, String const& file2 )
+{    RequireRegularFile(file1);
+     Remove(file2);
+     if ( link( file1.c_str( ), file2.c_str( ) ) == 0 ) return "hardlink";
+#ifdef FICLONE
+     int fd1 = open( file1.c_str( ), O_RDONLY );
+     if ( fd1 >= 0 )
+     {    int fd2 = open( file2.c_str( ), O_WRONLY|O_CREAT|O_TRUNC, 0666 );
+          bool cloned = fd2 >= 0 && ioctl( fd2, FICLONE, fd1 ) == 0;
+          if ( fd2 >= 0 ) close(fd2);
+          close(fd1);
+          if ( cloned ) return "reflink";
+          Remove(file2);    }
+#endif
+     Symlink( RealPath(file1), file2 );
+     return "symlink";    }
+
 String FirstLineOfFile( String filename )
 {    Ifstream( in, filename );
      String line;
@@ -185,6 +185,14 @@ void SymlinkForce( String existing_file, String name_of_symbolic_link );
 
 void Mv( String file1, String file2 );
 
+/// AdoptFile makes file2 another name for the contents of file1 without copying
+/// any data: a hard link if possible, else a copy-on-write clone (reflink) if
+/// the file system supports it, else a symbolic link to the absolute path of
+/// file1.  Any existing file2 is removed first.  Returns "hardlink", "reflink"
+/// or "symlink" to say which was done.  Either way, file2 must be treated as
+/// read-only, since writing through a hard link or symlink alters file1.
+String AdoptFile( String const& file1, String const& file2 );
+
 String FirstLineOfFile( String filename );
 
 /// Get the nth string from a file.